@@ -1,7 +1,7 @@
 #ifndef _PAREAS_COMPILER_AST_HPP
 #define _PAREAS_COMPILER_AST_HPP
 
-#include "futhark_generated.h"
+#include "pareas/compiler/futhark_interop.hpp"
 #include "pareas_grammar.hpp"
 
 #include <memory>
@@ -26,11 +26,11 @@ struct HostAst {
     size_t num_functions;
 
     std::unique_ptr<grammar::Production[]> node_types;
-    std::unique_ptr<int32_t[]> parents;
+    std::unique_ptr<futhark::Index[]> parents;
     std::unique_ptr<uint32_t[]> node_data;
     std::unique_ptr<DataType[]> data_types;
-    std::unique_ptr<int32_t[]> node_depths;
-    std::unique_ptr<int32_t[]> child_indexes;
+    std::unique_ptr<futhark::Index[]> node_depths;
+    std::unique_ptr<futhark::Index[]> child_indexes;
 
     std::unique_ptr<uint32_t[]> fn_tab;
 
@@ -38,14 +38,17 @@ struct HostAst {
 };
 
 struct DeviceAst {
+    // The Futhark array type of node indices, depths and child indexes, which depends on the `index-bits` option.
+    using IndexArray = futhark::ArrayTraits<futhark::Index, 1>::Array;
+
     futhark_context* ctx;
 
     futhark_u8_1d* node_types;
-    futhark_i32_1d* parents;
+    IndexArray* parents;
     futhark_u32_1d* node_data;
     futhark_u8_1d* data_types;
-    futhark_i32_1d* node_depths;
-    futhark_i32_1d* child_indexes;
+    IndexArray* node_depths;
+    IndexArray* child_indexes;
 
     futhark_u32_1d* fn_tab;
 
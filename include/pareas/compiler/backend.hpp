@@ -7,8 +7,18 @@
 #include "pareas/compiler/module.hpp"
 #include "pareas/profiler/profiler.hpp"
 
+#include <cstdint>
+
 namespace backend {
-    DeviceModule compile(futhark_context* ctx, DeviceAst& ast, pareas::Profiler& p);
+    enum class RegAlloc : uint8_t {
+        // Assign registers greedily, swapping out live symbols at calls.
+        GREEDY,
+        // Assign registers per live interval, using loop depth and use counts to decide what to spill.
+        LINEAR_SCAN,
+    };
+
+    // If `verbose` is set, statistics about the number of spilled symbols are printed to stderr.
+    DeviceModule compile(futhark_context* ctx, DeviceAst& ast, RegAlloc regalloc, bool verbose, pareas::Profiler& p);
 }
 
 #endif
@@ -9,6 +9,9 @@
 #include <chrono>
 #include <stdexcept>
 #include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <cstdio>
 #include <cstdint>
 
@@ -26,16 +29,45 @@ namespace frontend {
         TYPE_ERROR = 10,
         INVALID_RETURN = 11,
         MISSING_RETURN = 12,
+        UNKNOWN_ROOT = 13,
+        INPUT_TOO_LARGE = 14,
     };
 
     const char* error_name(Error e);
 
+    // The algorithm used to check whether the brackets derived from the input tokens match up.
+    enum class BracketCheck : uint8_t {
+        // Pick an algorithm based on the number of tokens and the maximum nesting depth.
+        AUTO,
+        BINARY_TREE,
+        RADIX,
+    };
+
     struct CompileError: std::runtime_error {
         CompileError(Error e):
             std::runtime_error(error_name(e)) {}
+
+        CompileError(Error e, std::string_view detail):
+            std::runtime_error(std::string(error_name(e)) + " '" + std::string(detail) + "'") {}
     };
 
-    DeviceAst compile(futhark_context* ctx, const std::string& input, bool verbose_tree, pareas::Profiler& p, std::FILE* debug_log);
+    // `roots` holds the names of the functions from which all other functions in the output must be
+    // reachable. Unreachable functions are removed. If empty, all functions are kept.
+    // Calls to leaf functions which return an expression of at most `inline_budget` nodes are inlined.
+    // If 0, no calls are inlined.
+    // During the syntax passes, the tree is compactified as soon as at least `compact_threshold` percent of
+    // its nodes are removed. If negative, the tree is only compactified at the fixed points in the pipeline.
+    DeviceAst compile(
+        futhark_context* ctx,
+        const std::string& input,
+        const std::vector<std::string_view>& roots,
+        int32_t inline_budget,
+        BracketCheck bracket_check,
+        int32_t compact_threshold,
+        bool verbose_tree,
+        pareas::Profiler& p,
+        std::FILE* debug_log
+    );
 }
 
 #endif
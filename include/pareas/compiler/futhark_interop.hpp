@@ -12,7 +12,21 @@
 #include <cassert>
 #include <cstdio>
 
+// The width of indices into the input, the tokens and the syntax tree, which is selected with the `index-bits`
+// build option. This must match src/compiler/index.fut or src/compiler/index64.fut.
+#ifndef PAREAS_INDEX_BITS
+    #define PAREAS_INDEX_BITS 32
+#endif
+
 namespace futhark {
+    #if PAREAS_INDEX_BITS == 64
+        using Index = int64_t;
+    #elif PAREAS_INDEX_BITS == 32
+        using Index = int32_t;
+    #else
+        #error "PAREAS_INDEX_BITS must be 32 or 64"
+    #endif
+
     template <typename T, void(*deleter)(T*)>
     struct Deleter {
         void operator()(T* t) const {
@@ -105,8 +119,10 @@ namespace futhark {
     using UniqueLexTable = UniqueOpaqueArray<futhark_opaque_lex_table, futhark_free_opaque_lex_table>;
     using UniqueParseTable = UniqueOpaqueArray<futhark_opaque_parse_table, futhark_free_opaque_parse_table>;
     using UniqueStackChangeTable = UniqueOpaqueArray<futhark_opaque_stack_change_table, futhark_free_opaque_stack_change_table>;
+    using UniqueFusedParseTable = UniqueOpaqueArray<futhark_opaque_fused_parse_table, futhark_free_opaque_fused_parse_table>;
     using UniqueTokenArray = UniqueOpaqueArray<futhark_opaque_arr_token_1d, futhark_free_opaque_arr_token_1d>;
     using UniqueTree = UniqueOpaqueArray<futhark_opaque_Tree, futhark_free_opaque_Tree>;
+    using UniqueTreeIndex = UniqueOpaqueArray<futhark_opaque_tree_index, futhark_free_opaque_tree_index>;
     using UniqueFuncInfoArray = UniqueOpaqueArray<futhark_opaque_arr_FuncInfo_1d, futhark_free_opaque_arr_FuncInfo_1d>;
     using UniqueInstrArray = UniqueOpaqueArray<futhark_opaque_arr_Instr_1d, futhark_free_opaque_arr_Instr_1d>;
 
@@ -193,24 +209,6 @@ namespace futhark {
         constexpr static const auto values_fn = futhark_values_u8_1d;
     };
 
-    template <>
-    struct ArrayTraits<uint16_t, 1> {
-        using Array = futhark_u16_1d;
-        constexpr static const auto new_fn = futhark_new_u16_1d;
-        constexpr static const auto free_fn = futhark_free_u16_1d;
-        constexpr static const auto shape_fn = futhark_shape_u16_1d;
-        constexpr static const auto values_fn = futhark_values_u16_1d;
-    };
-
-    template <>
-    struct ArrayTraits<uint16_t, 2> {
-        using Array = futhark_u16_2d;
-        constexpr static const auto new_fn = futhark_new_u16_2d;
-        constexpr static const auto free_fn = futhark_free_u16_2d;
-        constexpr static const auto shape_fn = futhark_shape_u16_2d;
-        constexpr static const auto values_fn = futhark_values_u16_2d;
-    };
-
     template <>
     struct ArrayTraits<uint32_t, 1> {
         using Array = futhark_u32_1d;
@@ -0,0 +1,76 @@
+#ifndef _PAREAS_GENERIC_BUNDLE_HPP
+#define _PAREAS_GENERIC_BUNDLE_HPP
+
+#include "pareas/lpg/bundle_format.hpp"
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+namespace pareas::generic {
+    struct BundleError: std::runtime_error {
+        BundleError(const std::string& msg): std::runtime_error(msg) {}
+    };
+
+    // A grammar bundle, as written by pareas-lpg --bundle. The bundle is mapped into memory rather than read,
+    // and sections which are already in the required representation are accessed in place. The structure of
+    // the bundle is validated when it is loaded, so that the accessors below only need to check that a
+    // section has the expected size. See pareas/lpg/bundle_format.hpp for a description of the format.
+    class Bundle {
+        const uint8_t* data;
+        size_t size;
+
+        bundle::GrammarInfo grammar_info;
+        std::vector<bundle::SectionEntry> sections;
+        std::vector<std::string_view> token_names;
+        std::vector<std::string_view> production_names;
+
+    public:
+        explicit Bundle(const char* path);
+        ~Bundle();
+
+        Bundle(Bundle&& other);
+        Bundle& operator=(Bundle&& other);
+
+        Bundle(const Bundle&) = delete;
+        Bundle& operator=(const Bundle&) = delete;
+
+        const bundle::GrammarInfo& info() const;
+        bool has_lexer() const;
+        bool has_parser() const;
+
+        std::string_view token_name(size_t id) const;
+        std::string_view production_name(size_t id) const;
+        std::optional<uint32_t> find_token(std::string_view name) const;
+
+        // Returns whether the bundle contains a section. Sections which were added in later minor versions
+        // may be missing.
+        bool has_section(bundle::SectionId id) const;
+
+        // Returns the number of items in a section.
+        size_t num_items(bundle::SectionId id) const;
+
+        // Returns the bytes of a section, after checking that it holds `count` items of `item_bytes` each.
+        std::span<const uint8_t> section(bundle::SectionId id, size_t item_bytes, size_t count) const;
+
+        // Returns a section of 32-bit signed integers, accessed in place.
+        std::span<const int32_t> i32_section(bundle::SectionId id, size_t count) const;
+
+        // Returns a section of unsigned integers of at most 32 bits, widened to 32 bits.
+        std::vector<uint32_t> u32_section(bundle::SectionId id, size_t item_bytes, size_t count) const;
+
+    private:
+        const bundle::SectionEntry* find_section(bundle::SectionId id) const;
+        const bundle::SectionEntry& require_section(bundle::SectionId id) const;
+
+        void validate();
+        std::vector<std::string_view> read_names(bundle::SectionId id, size_t count) const;
+    };
+}
+
+#endif
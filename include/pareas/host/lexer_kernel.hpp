@@ -0,0 +1,100 @@
+#ifndef _PAREAS_HOST_LEXER_KERNEL_HPP
+#define _PAREAS_HOST_LEXER_KERNEL_HPP
+
+#include <vector>
+#include <span>
+#include <limits>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+// This file should be kept in sync with src/compiler/lexer/lexer.fut and src/lpg/lexer/render.hpp.
+namespace pareas::host {
+    // The instruction sets that the lexer kernel has an implementation for.
+    enum class Isa {
+        SCALAR,
+        AVX2,
+        AVX512,
+    };
+
+    const char* isa_name(Isa isa);
+
+    // Returns whether the kernel for `isa` was compiled in and is supported by the CPU that we are running on.
+    bool isa_supported(Isa isa);
+
+    // The best instruction set supported by this CPU.
+    Isa detect_isa();
+
+    template <typename Token>
+    struct LexedToken {
+        Token token;
+        size_t start;
+    };
+
+    // Runs a lexer generated by pareas-lpg on the host, using the tables as emitted by the lexer generator: 256
+    // initial states, and the row-major n * n merge table. Like in the Futhark lexer, each transition is
+    // encoded as a state of which the highest bit marks whether the transition produces a token. `State`
+    // should be the type chosen by the lexer generator, `LexTable::State` in the generated header.
+    //
+    // The scan over the merge table is computed in blocks, each of which is divided into a number of lanes
+    // which are processed simultaneously: the states of each lane are first composed, which allows computing
+    // the state before the start of each lane, after which each lane is scanned again to compute the actual
+    // states. Depending on the instruction set, the lanes are either independent scalar dependency chains, or
+    // vectors of which the table lookups are performed using gathers.
+    template <typename State>
+    class LexerKernel {
+        static_assert(std::is_unsigned_v<State> && sizeof(State) <= sizeof(uint32_t));
+
+    public:
+        constexpr const static State PRODUCES_TOKEN = State(1) << (std::numeric_limits<State>::digits - 1);
+        constexpr const static State STATE_MASK = PRODUCES_TOKEN - 1;
+
+    private:
+        size_t n;
+        const State* initial_states;
+        const State* merge_table;
+        Isa isa;
+
+        // The merge table composed with the initial states, indexed by (state << 8) | byte. This saves one lookup
+        // per byte, and is usually much smaller than the merge table itself. It is padded with a few entries,
+        // so that the vector kernels may gather 32 bits at every entry.
+        std::vector<State> byte_transitions;
+
+    public:
+        // The tables are not copied, and must outlive the kernel. If `isa` is not supported, the best supported
+        // instruction set is used instead.
+        LexerKernel(size_t n, const State* initial_states, const State* merge_table, Isa isa = detect_isa());
+
+        Isa instruction_set() const;
+
+        // Compute the state after every byte of the input, as `scan merge identity (map initial input)` in the
+        // Futhark lexer does. `states` must be at least as long as `input`.
+        void scan(std::span<const uint8_t> input, std::span<State> states) const;
+
+        // Lex `input` and return each token together with its start offset, in the same way as the `lex`
+        // function of the Futhark lexer. `final_states` is indexed by the states of the lexer.
+        template <typename Token>
+        std::vector<LexedToken<Token>> lex(std::span<const uint8_t> input, const Token* final_states) const {
+            auto states = std::vector<State>(input.size());
+            this->scan(input, states);
+
+            // A token ends at byte i if the transition to byte i + 1 produces a token, or if it is the last byte.
+            auto tokens = std::vector<LexedToken<Token>>();
+            size_t start = 0;
+            for (size_t i = 0; i < input.size(); ++i) {
+                if (i + 1 == input.size() || (states[i + 1] & PRODUCES_TOKEN)) {
+                    tokens.push_back({final_states[states[i] & STATE_MASK], start});
+                    start = i + 1;
+                }
+            }
+
+            return tokens;
+        }
+    };
+
+    extern template class LexerKernel<uint8_t>;
+    extern template class LexerKernel<uint16_t>;
+    extern template class LexerKernel<uint32_t>;
+}
+
+#endif
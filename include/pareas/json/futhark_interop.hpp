@@ -11,7 +11,21 @@
 #include <cassert>
 #include <cstdio>
 
+// The width of indices into the tokens and the document tree, which is selected with the `index-bits`
+// build option. This must match src/compiler/index.fut or src/compiler/index64.fut.
+#ifndef PAREAS_INDEX_BITS
+    #define PAREAS_INDEX_BITS 32
+#endif
+
 namespace futhark {
+    #if PAREAS_INDEX_BITS == 64
+        using Index = int64_t;
+    #elif PAREAS_INDEX_BITS == 32
+        using Index = int32_t;
+    #else
+        #error "PAREAS_INDEX_BITS must be 32 or 64"
+    #endif
+
     template <typename T, void(*deleter)(T*)>
     struct Deleter {
         void operator()(T* t) const {
@@ -173,24 +187,6 @@ namespace futhark {
         constexpr static const auto values_fn = futhark_values_u8_1d;
     };
 
-    template <>
-    struct ArrayTraits<uint16_t, 1> {
-        using Array = futhark_u16_1d;
-        constexpr static const auto new_fn = futhark_new_u16_1d;
-        constexpr static const auto free_fn = futhark_free_u16_1d;
-        constexpr static const auto shape_fn = futhark_shape_u16_1d;
-        constexpr static const auto values_fn = futhark_values_u16_1d;
-    };
-
-    template <>
-    struct ArrayTraits<uint16_t, 2> {
-        using Array = futhark_u16_2d;
-        constexpr static const auto new_fn = futhark_new_u16_2d;
-        constexpr static const auto free_fn = futhark_free_u16_2d;
-        constexpr static const auto shape_fn = futhark_shape_u16_2d;
-        constexpr static const auto values_fn = futhark_values_u16_2d;
-    };
-
     template <>
     struct ArrayTraits<int32_t, 1> {
         using Array = futhark_i32_1d;
@@ -200,6 +196,17 @@ namespace futhark {
         constexpr static const auto values_fn = futhark_values_i32_1d;
     };
 
+#if PAREAS_INDEX_BITS == 64
+    template <>
+    struct ArrayTraits<int64_t, 1> {
+        using Array = futhark_i64_1d;
+        constexpr static const auto new_fn = futhark_new_i64_1d;
+        constexpr static const auto free_fn = futhark_free_i64_1d;
+        constexpr static const auto shape_fn = futhark_shape_i64_1d;
+        constexpr static const auto values_fn = futhark_values_i64_1d;
+    };
+#endif
+
     template <>
     struct ArrayTraits<int32_t, 2> {
         using Array = futhark_i32_2d;
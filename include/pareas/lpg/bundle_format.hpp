@@ -0,0 +1,106 @@
+#ifndef _PAREAS_LPG_BUNDLE_FORMAT_HPP
+#define _PAREAS_LPG_BUNDLE_FORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// This file describes the binary grammar bundle written by pareas-lpg --bundle, which contains the lexer and
+// parser tables of a grammar in a form that can be loaded at runtime. It is shared between the generator
+// (src/lpg/bundle_writer.cpp) and the readers (src/generic/bundle.cpp), and should be kept in sync with the
+// table encodings described in src/lpg/lexer/render.hpp and src/lpg/parser/llp/render.hpp.
+//
+// A bundle starts with a `Header`, followed by `Header::num_sections` `SectionEntry`s. Each section is a
+// contiguous range of bytes that holds an array of `SectionEntry::item_bytes`-wide little-endian integers.
+// The grammar info section holds a single `GrammarInfo`, of which later minor versions may append fields,
+// and the name sections are described below. Every section starts at an offset aligned to `SECTION_ALIGN`
+// bytes, so that a mapped bundle can be accessed in place. Readers should ignore sections they don't know
+// about, and should reject bundles of which the major version differs from theirs.
+namespace pareas::bundle {
+    constexpr const char MAGIC[8] = {'P', 'A', 'R', 'E', 'A', 'S', 'G', 'B'};
+    constexpr const uint16_t VERSION_MAJOR = 1;
+    constexpr const uint16_t VERSION_MINOR = 1;
+    constexpr const size_t SECTION_ALIGN = 8;
+
+    // Value of the special token fields of `GrammarInfo` if the grammar does not use that token.
+    constexpr const uint32_t NO_TOKEN = 0xFFFFFFFF;
+
+    enum class SectionId : uint32_t {
+        GRAMMAR_INFO = 1,
+        // The name of each token, indexed by token ID.
+        TOKEN_NAMES = 2,
+        // The lexer tables, as rendered by the lexer generator: 256 initial states, the n * n merge table
+        // and the token produced by each of the n states. States are encoded as in the rendered lexer,
+        // of which the highest bit of `GrammarInfo::lexer_state_bits` marks whether a transition produces
+        // a token.
+        LEXER_INITIAL_STATES = 3,
+        LEXER_MERGE_TABLE = 4,
+        LEXER_FINAL_STATES = 5,
+        // The tag of each production, indexed by production ID.
+        PRODUCTION_NAMES = 6,
+        // The number of non-terminals in the right hand side of each production, as 32-bit integers.
+        PRODUCTION_ARITIES = 7,
+        // The string tables of the parser: the superstring, and the offsets and lengths of the string of each
+        // pair of tokens, as num_tokens * num_tokens row-major 32-bit signed integers. Pairs of tokens which
+        // may not appear next to each other have an offset and length of -1.
+        STACK_CHANGE_TABLE = 8,
+        STACK_CHANGE_OFFSETS = 9,
+        STACK_CHANGE_LENGTHS = 10,
+        PARSE_TABLE = 11,
+        PARSE_OFFSETS = 12,
+        PARSE_LENGTHS = 13,
+        // The operator list metadata of each production, as 32-bit integers, see `ParserTables` in
+        // src/lpg/parser/llp/render.hpp. Only present if the grammar declares operator lists (since 1.1).
+        OPERATOR_LIST_ROLES = 14,
+        LEFT_ASSOC_LISTS = 15,
+    };
+
+    struct Header {
+        char magic[8];
+        uint16_t version_major;
+        uint16_t version_minor;
+        uint32_t num_sections;
+    };
+
+    struct SectionEntry {
+        SectionId id;
+        uint32_t item_bytes;
+        // Offset and size in bytes, relative to the start of the bundle.
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    enum GrammarFlags : uint32_t {
+        HAS_LEXER = 1 << 0,
+        HAS_PARSER = 1 << 1,
+    };
+
+    struct GrammarInfo {
+        uint32_t flags;
+
+        uint32_t num_tokens;
+        uint32_t token_bits;
+        uint32_t token_invalid;
+        uint32_t token_soi;
+        uint32_t token_eoi;
+
+        // Only valid if HAS_LEXER is set.
+        uint32_t lexer_states;
+        uint32_t lexer_state_bits;
+        uint32_t lexer_identity_state;
+
+        // Only valid if HAS_PARSER is set.
+        uint32_t num_productions;
+        uint32_t production_bits;
+        uint32_t bracket_bits;
+    };
+
+    // Name sections have an item size of 1 byte, and consist of the number of names n and n + 1 offsets, all as
+    // 32-bit integers, followed by the characters of all the names. The i-th name consists of the characters in
+    // [offsets[i], offsets[i + 1]), relative to the start of the characters. Names are not null-terminated.
+
+    static_assert(sizeof(Header) == 16);
+    static_assert(sizeof(SectionEntry) == 24);
+    static_assert(sizeof(GrammarInfo) == 48);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef _PAREAS_LPG_BUNDLE_WRITER_HPP
+#define _PAREAS_LPG_BUNDLE_WRITER_HPP
+
+#include "pareas/lpg/bundle_format.hpp"
+#include "pareas/lpg/token_mapping.hpp"
+#include "pareas/lpg/lexer/render.hpp"
+#include "pareas/lpg/parser/grammar.hpp"
+#include "pareas/lpg/parser/llp/render.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace pareas {
+    // Collects the tables of a lexer and/or parser, and writes them to a grammar bundle. See
+    // pareas/lpg/bundle_format.hpp for a description of the format.
+    class BundleWriter {
+        struct Section {
+            bundle::SectionId id;
+            uint32_t item_bytes;
+            std::string data;
+        };
+
+        bundle::GrammarInfo info;
+        std::vector<Section> sections;
+
+    public:
+        BundleWriter(const TokenMapping& tm);
+
+        void add_lexer(const lexer::LexerTables& tables);
+        void add_parser(const parser::Grammar& g, const parser::llp::ParserTables& tables);
+
+        void write(const std::filesystem::path& path) const;
+
+    private:
+        Section& add_section(bundle::SectionId id, size_t item_bytes);
+
+        template <typename T>
+        void add_int_section(bundle::SectionId id, size_t item_bytes, const std::vector<T>& values);
+
+        template <typename F>
+        void add_names_section(bundle::SectionId id, size_t n, F get_name);
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef _PAREAS_LPG_CACHE_HPP
+#define _PAREAS_LPG_CACHE_HPP
+
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace pareas {
+    // The version of the generators, which is part of the key of every cache entry. This should be bumped whenever
+    // the output of the lexer or parser generator changes for the same input, or the format of an entry changes.
+    constexpr const uint32_t GENERATOR_VERSION = 1;
+
+    struct CacheError: std::runtime_error {
+        CacheError(const std::string& msg): std::runtime_error(msg) {}
+    };
+
+    // Serializes values to a little-endian binary string, to be stored in the generation cache.
+    class CacheWriter {
+        std::string buffer;
+
+    public:
+        void write_u8(uint8_t value);
+        void write_u32(uint32_t value);
+        void write_u64(uint64_t value);
+        void write_string(std::string_view value);
+
+        const std::string& data() const;
+    };
+
+    // Deserializes values written by a `CacheWriter`. Reading past the end of the data throws a `CacheError`.
+    class CacheReader {
+        std::string_view buffer;
+        size_t offset;
+
+    public:
+        explicit CacheReader(std::string_view buffer);
+
+        uint8_t read_u8();
+        uint32_t read_u32();
+        uint64_t read_u64();
+        std::string_view read_string();
+
+        // Read an index, and check that it is smaller than `bound`.
+        size_t read_index(size_t bound);
+
+        // The number of bytes which have not been read yet.
+        size_t remaining() const;
+
+        // Check that all data has been read.
+        void finish() const;
+
+    private:
+        const char* consume(size_t bytes);
+    };
+
+    // A cache of intermediate generation results, stored as one file per entry in a directory. Entries are keyed
+    // by a kind, which identifies the type of result, and the source it was generated from. Because the source is
+    // stored with the entry and compared when it is loaded, hash collisions never cause a wrong entry to be used.
+    // The cache is only an optimization, so errors while storing an entry are reported, but not fatal.
+    class GenerationCache {
+        std::filesystem::path dir;
+
+    public:
+        explicit GenerationCache(const std::filesystem::path& dir);
+
+        std::optional<std::string> load(std::string_view kind, std::string_view source) const;
+        void store(std::string_view kind, std::string_view source, const std::string& data) const;
+
+    private:
+        std::filesystem::path entry_path(std::string_view kind, std::string_view source) const;
+    };
+}
+
+#endif
@@ -3,15 +3,54 @@
 
 #include "pareas/lpg/lexer/parallel_lexer.hpp"
 
+#include <vector>
+#include <array>
 #include <string_view>
+#include <iosfwd>
+#include <cstddef>
+#include <cstdint>
 
 namespace pareas::lexer {
-    struct LexerInterpreter {
+    // Runs a parallel lexer on the host. This computes the same tokens as the Futhark lexer (see
+    // src/compiler/lexer/lexer.fut), but evaluates the scan over the merge table in chunks on multiple threads:
+    // the states of each chunk are first composed into a single state, these are then combined sequentially to
+    // find the state at the start of each chunk, after which the chunks are lexed independently.
+    class LexerInterpreter {
+    public:
+        // Chunks smaller than this are not worth the overhead of an extra pass over the input.
+        constexpr const static size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+        struct Token {
+            // Null if the token does not match any lexeme, in which case it covers the remainder of the input.
+            const Lexeme* lexeme;
+            size_t offset;
+            size_t size;
+        };
+
+        LexerInterpreter(const ParallelLexer* lexer, size_t threads = 1);
+
+        // Split `input` into tokens. If the input can not be lexed, the last token does not match any lexeme.
+        std::vector<Token> lex(std::string_view input) const;
+
+        // Lex `input` and print the name, offset and size of each token, for debugging purposes.
+        void dump_tokens(std::ostream& out, std::string_view input) const;
+
+    private:
         const ParallelLexer* lexer;
+        size_t threads;
+
+        // The lexer tables are copied into a denser encoding, which makes the lookups much more cache friendly:
+        // A transition is stored as the resulting state, of which the highest bit is set if the transition
+        // produces a lexeme. Like in the parallel lexer, the merge table is stored column-major.
+        using PackedTransition = uint32_t;
+        constexpr const static PackedTransition PRODUCES_LEXEME = PackedTransition(1) << 31;
 
-        LexerInterpreter(const ParallelLexer* lexer);
+        std::array<PackedTransition, 256> initial_states;
+        std::vector<PackedTransition> merge_table;
+        size_t num_states;
 
-        void lex_linear(std::string_view input) const;
+        PackedTransition initial(char c) const;
+        PackedTransition merge(PackedTransition first, PackedTransition second) const;
     };
 }
 
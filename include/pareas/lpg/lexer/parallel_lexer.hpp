@@ -3,6 +3,7 @@
 
 #include "pareas/lpg/lexer/lexical_grammar.hpp"
 #include "pareas/lpg/lexer/fsa.hpp"
+#include "pareas/lpg/cache.hpp"
 
 #include <span>
 #include <memory>
@@ -65,7 +66,16 @@ namespace pareas::lexer {
 
         explicit ParallelLexer(const LexicalGrammar* g);
 
+        // Serialize this lexer for the generation cache. Lexemes are stored by their index in `g`, which
+        // should be the grammar this lexer was generated from.
+        void save(CacheWriter& w, const LexicalGrammar& g) const;
+        // Deserialize a lexer stored by `save`, for a grammar parsed from the same source.
+        static ParallelLexer load(CacheReader& r, const LexicalGrammar& g);
+
         void dump_sizes(std::ostream& out) const;
+
+    private:
+        ParallelLexer() = default;
     };
 }
 
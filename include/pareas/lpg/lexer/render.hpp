@@ -5,32 +5,46 @@
 #include "pareas/lpg/token_mapping.hpp"
 #include "pareas/lpg/lexer/parallel_lexer.hpp"
 
-#include <limits>
-#include <span>
+#include <vector>
 #include <iosfwd>
 #include <cstdint>
 #include <cstddef>
 
 namespace pareas::lexer {
-    class LexerRenderer {
-        using EncodedTransition = uint16_t;
-        constexpr const static auto ENCODED_TRANSITION_BITS = std::numeric_limits<EncodedTransition>::digits;
-        constexpr const static auto PRODUCES_TOKEN_MASK = 1 << (ENCODED_TRANSITION_BITS - 1);
+    // The tables of a parallel lexer, encoded as they are consumed by the lexer runtime.
+    struct LexerTables {
+        // Transitions are encoded as a state index, of which the highest bit is used to mark
+        // whether the transition produces a token. The width of the encoding is chosen as narrow
+        // as possible for the lexer.
+        using EncodedTransition = uint64_t;
+
+        size_t states;
+        size_t state_bits;
+        size_t token_bits;
+        EncodedTransition identity_state;
+
+        std::vector<EncodedTransition> initial_states; // 256
+        std::vector<EncodedTransition> merge_table; // states * states
+        std::vector<uint64_t> final_states; // states
 
+        LexerTables(const TokenMapping& tm, const ParallelLexer& lexer);
+
+    private:
+        EncodedTransition encode(const ParallelLexer::Transition& t) const;
+        EncodedTransition produces_token_mask() const;
+    };
+
+    class LexerRenderer {
         Renderer* r;
-        const TokenMapping* tm;
-        const ParallelLexer* lexer;
+        LexerTables tables;
 
     public:
         LexerRenderer(Renderer* r, const TokenMapping* tm, const ParallelLexer* lexer);
         void render() const;
 
     private:
-        size_t render_initial_state_data() const;
-        size_t render_merge_table_data() const;
+        size_t render_states(const std::vector<LexerTables::EncodedTransition>& states) const;
         size_t render_final_state_data() const;
-
-        EncodedTransition encode(const ParallelLexer::Transition& t) const;
     };
 }
 
@@ -0,0 +1,93 @@
+#ifndef _PAREAS_LPG_PARALLEL_UTIL_HPP
+#define _PAREAS_LPG_PARALLEL_UTIL_HPP
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+namespace pareas {
+    // Resolve a requested number of threads, where 0 means to use every hardware thread.
+    inline size_t resolve_thread_count(size_t threads) {
+        if (threads != 0)
+            return threads;
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // Invoke `f(i)` for every `i` in [0, n), dynamically distributed over at most `threads` threads, one of
+    // which is the calling thread. The order in which the indices are processed is unspecified, so `f` should
+    // only write to state belonging to `i`. If `f` throws, the remaining indices are skipped and the first
+    // exception is rethrown on the calling thread.
+    template <typename F>
+    void parallel_for(size_t threads, size_t n, F f) {
+        threads = std::min(threads, n);
+        if (threads <= 1) {
+            for (size_t i = 0; i < n; ++i)
+                f(i);
+            return;
+        }
+
+        auto next = std::atomic<size_t>(0);
+        auto error = std::exception_ptr();
+        auto error_mutex = std::mutex();
+
+        auto worker = [&] {
+            try {
+                size_t i;
+                while ((i = next.fetch_add(1, std::memory_order_relaxed)) < n)
+                    f(i);
+            } catch (...) {
+                auto lock = std::scoped_lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                next.store(n, std::memory_order_relaxed);
+            }
+        };
+
+        auto pool = std::vector<std::thread>();
+        pool.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i)
+            pool.emplace_back(worker);
+
+        worker();
+
+        for (auto& thread : pool)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // A division of [0, n) into contiguous chunks, for algorithms which process each chunk sequentially and
+    // combine the results of the chunks afterwards. Chunk `i` consists of the indices in [begin(i), end(i)).
+    struct Chunking {
+        // Spread the work of each thread over a few chunks, so that `parallel_for` can balance the load.
+        constexpr const static size_t CHUNKS_PER_THREAD = 4;
+
+        size_t n;
+        size_t chunks;
+
+        // Divide [0, n) into chunks of at least `min_chunk_size` elements, unless n itself is smaller. There is
+        // always at least one chunk, and only one if there is only a single thread.
+        Chunking(size_t threads, size_t n, size_t min_chunk_size):
+            n(n),
+            chunks(std::clamp<size_t>(
+                n / std::max<size_t>(min_chunk_size, 1),
+                1,
+                threads <= 1 ? 1 : threads * CHUNKS_PER_THREAD
+            )) {}
+
+        size_t begin(size_t i) const {
+            return i * this->n / this->chunks;
+        }
+
+        size_t end(size_t i) const {
+            return (i + 1) * this->n / this->chunks;
+        }
+    };
+}
+
+#endif
@@ -6,10 +6,15 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <iosfwd>
 #include <stdexcept>
 #include <string_view>
 #include <cstddef>
+#include <cstdint>
 
 namespace pareas::parser {
     struct InvalidGrammarError: std::runtime_error {
@@ -20,9 +25,15 @@ namespace pareas::parser {
         TokenLinkError(): InvalidGrammarError("Undefined token") {}
     };
 
+    // Grammar symbols are identified by a dense integer ID rather than by their name, so that they can be
+    // hashed and compared cheaply. IDs are assigned by interning the name of the symbol in the `SymbolTable` of
+    // the grammar, which happens when the grammar is parsed. Terminals and non-terminals are numbered separately.
+    // Symbols also refer to their name in that table, which must outlive them.
+    using SymbolId = uint32_t;
+
     struct Terminal {
         enum class Type {
-            USER_DEFINED, // `name` contains a user defined string.
+            USER_DEFINED, // `name()` returns a user defined string.
             EMPTY, // ε
             START_OF_INPUT, // ⊢
             END_OF_INPUT // ⊣
@@ -33,8 +44,11 @@ namespace pareas::parser {
         static const Terminal END_OF_INPUT;
 
         Type type;
-        std::string name;
+        // The special terminals above take the first IDs.
+        SymbolId id;
+        const std::string* interned_name;
 
+        const std::string& name() const;
         Token as_token() const;
 
         bool is_empty() const;
@@ -46,7 +60,10 @@ namespace pareas::parser {
     };
 
     struct NonTerminal {
-        std::string name;
+        SymbolId id;
+        const std::string* interned_name;
+
+        const std::string& name() const;
 
         bool operator==(const NonTerminal& other) const;
 
@@ -65,11 +82,15 @@ namespace pareas::parser {
         };
 
         Type type;
-        std::string name;
+        // The ID of the terminal or non-terminal, depending on `type`.
+        SymbolId id;
+        const std::string* interned_name;
 
         Symbol(Terminal t);
         Symbol(NonTerminal nt);
 
+        const std::string& name() const;
+
         bool is_empty_terminal() const;
         bool is_terminal() const;
         bool operator==(const Symbol& other) const;
@@ -82,6 +103,46 @@ namespace pareas::parser {
         };
     };
 
+    // Assigns dense IDs to the names of the terminals and non-terminals of a grammar, in order of first
+    // appearance. Every grammar has its own table, which is only modified while the grammar is parsed, so that
+    // the IDs of a grammar do not depend on other grammars and the table may be read from multiple threads.
+    // The names are stored in deques, so that references to them (and the string views used as keys) remain
+    // valid when more names are interned.
+    class SymbolTable {
+        struct Names {
+            std::deque<std::string> names;
+            std::unordered_map<std::string_view, SymbolId> ids;
+
+            SymbolId intern(std::string_view name);
+            std::optional<SymbolId> find(std::string_view name) const;
+        };
+
+        Names terminals;
+        Names non_terminals;
+
+    public:
+        // The special terminals are interned first, so that they take the IDs of `Terminal::EMPTY`,
+        // `Terminal::START_OF_INPUT` and `Terminal::END_OF_INPUT`.
+        SymbolTable();
+
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        Terminal intern_terminal(std::string_view name);
+        NonTerminal intern_non_terminal(std::string_view name);
+
+        std::optional<Terminal> find_terminal(std::string_view name) const;
+        std::optional<NonTerminal> find_non_terminal(std::string_view name) const;
+
+        // Reconstruct a symbol from an ID assigned by this table.
+        Terminal terminal(SymbolId id) const;
+        NonTerminal non_terminal(SymbolId id) const;
+
+        // The number of IDs assigned, including the special terminals.
+        size_t num_terminals() const;
+        size_t num_non_terminals() const;
+    };
+
     struct Production {
         SourceLocation loc;
         std::string tag;
@@ -91,10 +152,37 @@ namespace pareas::parser {
         size_t arity() const;
     };
 
+    // An operator list is a non-terminal which encodes a chain of binary operators of the same precedence, in
+    // the only way that an LL grammar can: as a right-recursive list. Each of its productions is either an
+    // operator, of the form `list -> ... list;`, or an end of the list, of the form `list -> ;`. Operator lists
+    // are declared in the grammar with `%left` and `%right`, which allows the parse tree to be restructured into
+    // a proper expression tree afterwards, see src/compiler/parser/reassociate.fut.
+    struct OperatorList {
+        enum class Associativity {
+            LEFT,
+            RIGHT,
+        };
+
+        SourceLocation loc;
+        NonTerminal nt;
+        Associativity assoc;
+    };
+
+    // The role that a production plays in an operator list.
+    enum class OperatorListRole {
+        NONE,
+        OPERATOR,
+        END,
+    };
+
     struct Grammar {
         constexpr const static size_t START_INDEX = 0;
 
         std::vector<Production> productions;
+        // In order of declaration, which is from lowest to highest precedence.
+        std::vector<OperatorList> operator_lists;
+        // The names of the symbols in `productions` and `operator_lists`.
+        std::shared_ptr<const SymbolTable> symbols;
 
         void dump(std::ostream& os) const;
         void validate(ErrorReporter& er) const;
@@ -105,20 +193,21 @@ namespace pareas::parser {
         size_t production_id(const Production* p) const;
         size_t production_backing_type_bits() const;
 
+        // Returns the operator list that a production is part of, or null if it is not part of one.
+        const OperatorList* operator_list(const Production* p) const;
+        OperatorListRole operator_list_role(const Production* p) const;
+
     private:
         bool check_production_definitions(ErrorReporter& er) const;
         bool check_start_rule(ErrorReporter& er) const;
+        bool check_operator_lists(ErrorReporter& er) const;
     };
 
     std::ostream& operator<<(std::ostream& os, const Terminal& t);
     std::ostream& operator<<(std::ostream& os, const NonTerminal& nt);
     std::ostream& operator<<(std::ostream& os, const Symbol& sym);
     std::ostream& operator<<(std::ostream& os, const Production& prod);
-
-    namespace literals {
-        Terminal operator ""_t(const char* name, size_t len);
-        NonTerminal operator ""_nt(const char* name, size_t len);
-    }
+    std::ostream& operator<<(std::ostream& os, const OperatorList& list);
 }
 
 #endif
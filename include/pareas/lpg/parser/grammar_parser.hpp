@@ -6,6 +6,7 @@
 
 #include <string_view>
 #include <unordered_map>
+#include <memory>
 #include <cstddef>
 
 namespace pareas::parser {
@@ -17,7 +18,9 @@ namespace pareas::parser {
         Parser* parser;
 
         std::vector<Production> productions;
+        std::vector<OperatorList> operator_lists;
         std::unordered_map<std::string_view, SourceLocation> tags;
+        std::shared_ptr<SymbolTable> symbols;
 
     public:
         GrammarParser(Parser* parser);
@@ -25,6 +28,7 @@ namespace pareas::parser {
 
     private:
         bool production();
+        bool operator_list_declaration(); // %left|%right word...;
         std::string_view terminal(); // quoted word
         std::string_view tag(); // [word]
     };
@@ -25,10 +25,29 @@ namespace pareas::parser::ll {
     };
 
     struct ParsingTable {
+        // The result of parsing a single lookahead when a single non-terminal is on top of the stack.
+        struct Expansion {
+            std::vector<const Production*> productions;
+            // The symbols that are pushed onto the rest of the stack, with the top at the back.
+            std::vector<Symbol> residue;
+            // Whether the lookahead was matched. If not, the non-terminal derived ε, and parsing continues
+            // with the next symbol on the stack.
+            bool matched;
+        };
+
         std::unordered_map<State, const Production*, State::Hash> table;
 
+        // Expansions are derived from `table` by `compute_expansions`, which needs to be called after the
+        // table is complete. Many partial parses share the same expansions, so this makes the cost of a
+        // partial parse proportional to the size of its result.
+        std::unordered_map<State, Expansion, State::Hash> expansions;
+
+        void compute_expansions();
         std::vector<const Production*> partial_parse(const Terminal& y, std::vector<Symbol>& stack) const;
         void dump_csv(std::ostream& os) const;
+
+    private:
+        const Expansion& expand(const State& state);
     };
 }
 
@@ -10,28 +10,58 @@
 #include "pareas/lpg/parser/llp/psls_table.hpp"
 #include "pareas/lpg/parser/llp/parsing_table.hpp"
 
-#include <unordered_set>
+#include <vector>
+#include <span>
 #include <iosfwd>
+#include <cstddef>
+#include <cstdint>
 
 namespace pareas::parser::llp {
     class Generator {
+        // A gamma sequence which is computed while item sets are explored in parallel. During that time the gamma
+        // arena must not be modified, so new gammas are interned afterwards. The gamma consists of the first `len`
+        // symbols of `sym` followed by the gamma `delta`.
+        struct PendingGamma {
+            Symbol sym;
+            GammaId delta;
+            uint32_t len;
+
+            bool operator==(const PendingGamma& other) const;
+
+            struct Hash {
+                size_t operator()(const PendingGamma& pg) const;
+            };
+        };
+
+        // The predecessor set of an item set under a single symbol, before it is added to the item set arena.
+        // The gamma of each item is an index into `gammas` rather than a gamma ID.
+        struct Expansion {
+            std::vector<Item> items;
+            std::vector<PendingGamma> gammas;
+        };
+
         ErrorReporter* er;
         const Grammar* g;
         const TerminalSetFunctions* tsf;
+        size_t threads;
 
-        std::unordered_set<ItemSet, ItemSet::Hash> item_sets;
+        GammaArena gammas;
+        // The item sets, in the order in which they were discovered.
+        ItemSetArena item_sets;
 
     public:
-        Generator(ErrorReporter* er, const Grammar* g, const TerminalSetFunctions* tsf);
+        // `threads` is the maximum number of threads used to generate the tables. The results do not
+        // depend on it.
+        Generator(ErrorReporter* er, const Grammar* g, const TerminalSetFunctions* tsf, size_t threads = 1);
         PSLSTable build_psls_table();
         ParsingTable build_parsing_table(const ll::ParsingTable& ll, const PSLSTable& psls);
         void dump(std::ostream& os);
 
     private:
         void compute_item_sets();
-        ItemSet predecessor(const ItemSet& set, const Symbol& sym);
-        void closure(ItemSet& set);
-        std::vector<Symbol> compute_gamma(const Terminal& v, const Symbol& x, std::span<const Symbol> delta);
+        Expansion predecessor(const ItemSet& set, const Symbol& sym) const;
+        void closure(std::vector<Item>& items) const;
+        uint32_t compute_gamma_len(const Terminal& v, const Symbol& x, std::span<const Symbol> delta) const;
     };
 }
 
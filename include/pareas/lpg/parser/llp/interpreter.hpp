@@ -0,0 +1,56 @@
+#ifndef _PAREAS_LPG_PARSER_LLP_INTERPRETER_HPP
+#define _PAREAS_LPG_PARSER_LLP_INTERPRETER_HPP
+
+#include "pareas/lpg/parser/grammar.hpp"
+#include "pareas/lpg/parser/llp/parsing_table.hpp"
+
+#include <vector>
+#include <span>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+
+namespace pareas::parser::llp {
+    // Runs an LLP parser on the host. Like the Futhark parser (see src/compiler/parser/parser.fut), every pair of
+    // adjacent tokens is looked up in the parsing table, which yields a sequence of brackets and a partial
+    // derivation. The input is accepted if the brackets of all pairs together are balanced, and the derivation
+    // is then the concatenation of the partial derivations. The input is divided into chunks, which are processed
+    // on multiple threads: the brackets of each chunk are matched locally, and only the brackets which remain
+    // unmatched are matched sequentially afterwards.
+    class ParserInterpreter {
+    public:
+        // Chunks smaller than this are not worth the overhead of the sequential pass over their unmatched brackets.
+        constexpr const static size_t MIN_CHUNK_SIZE = 16 * 1024;
+
+        // The parent of the root of the parse tree.
+        constexpr const static int64_t NO_PARENT = -1;
+
+    private:
+        const Grammar* g;
+        size_t threads;
+
+        // The entries of the parsing table, indexed by the IDs of the terminals of the admissible pair as
+        // `x * num_terminals + y`. Null if the pair is not admissible.
+        size_t num_terminals;
+        std::vector<const ParsingTable::Entry*> entries;
+
+        // The number of non-terminals on the right hand side of each production, indexed by production ID.
+        std::vector<size_t> arities;
+
+    public:
+        ParserInterpreter(const Grammar* g, const ParsingTable* llp_table, size_t threads = 1);
+
+        // Parse `input`, which should not include the start- and end-of-input terminals. Returns the
+        // productions of the leftmost derivation of the input, or nothing if the input is rejected.
+        std::optional<std::vector<const Production*>> parse(std::span<const Terminal> input) const;
+
+        // Given a derivation as returned by `parse`, compute the index of the parent of each production in the
+        // parse tree. The parent of the root is `NO_PARENT`.
+        std::vector<int64_t> build_parent_vector(std::span<const Production* const> derivation) const;
+
+    private:
+        const ParsingTable::Entry* lookup(const Terminal& x, const Terminal& y) const;
+    };
+}
+
+#endif
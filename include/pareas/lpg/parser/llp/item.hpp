@@ -2,19 +2,25 @@
 #define _PAREAS_LPG_PARSER_LLP_ITEM_HPP
 
 #include "pareas/lpg/parser/grammar.hpp"
+#include "pareas/lpg/parser/llp/span_arena.hpp"
 
-#include <vector>
 #include <iosfwd>
 #include <span>
 #include <cstddef>
+#include <cstdint>
 
 namespace pareas::parser::llp {
+    // Gamma sequences are shared between many items, so they are interned in a `GammaArena` and items
+    // only refer to them by ID.
+    using GammaArena = SpanArena<Symbol, Symbol::Hash>;
+    using GammaId = GammaArena::Id;
+
     struct Item {
         const Production* prod;
-        size_t dot;
+        uint32_t dot;
         Terminal lookback;
         Terminal lookahead;
-        std::vector<Symbol> gamma;
+        GammaId gamma;
 
         bool is_dot_at_end() const;
         bool is_dot_at_begin() const;
@@ -31,8 +37,10 @@ namespace pareas::parser::llp {
     };
 
     bool operator==(const Item& lhs, const Item& rhs);
+    // An arbitrary but fixed order, used to give item sets a canonical representation.
+    bool operator<(const Item& lhs, const Item& rhs);
 
-    std::ostream& operator<<(std::ostream& os, const Item& item);
+    void dump_item(std::ostream& os, const Item& item, const GammaArena& gammas);
 }
 
 #endif
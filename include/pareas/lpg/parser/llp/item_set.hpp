@@ -2,26 +2,32 @@
 #define _PAREAS_LPG_PARSER_LLP_ITEM_SET_HPP
 
 #include "pareas/lpg/parser/llp/item.hpp"
+#include "pareas/lpg/parser/llp/span_arena.hpp"
 #include "pareas/lpg/parser/grammar.hpp"
 
 #include <iosfwd>
-#include <unordered_set>
+#include <vector>
+#include <span>
 #include <cstddef>
 
 namespace pareas::parser::llp {
+    // Item sets are stored in an arena as sorted vectors of unique items, so that equal sets have the same
+    // representation and every distinct set is stored only once.
+    using ItemSetArena = SpanArena<Item, Item::Hash>;
+    using ItemSetId = ItemSetArena::Id;
+
+    // A view of the items of a single set. The items are sorted and unique.
     struct ItemSet {
-        std::unordered_set<Item, Item::Hash> items;
+        std::span<const Item> items;
 
-        std::unordered_set<Symbol, Symbol::Hash> syms_before_dots() const;
-        std::unordered_set<Symbol, Symbol::Hash> syms_after_dots() const;
-        void dump(std::ostream& os) const;
+        // Bring a vector of items into the canonical representation of an item set.
+        static void canonicalize(std::vector<Item>& items);
 
-        struct Hash {
-            size_t operator()(const ItemSet& item_set) const;
-        };
+        // The symbols are returned in the order in which they first appear in the set.
+        std::vector<Symbol> syms_before_dots() const;
+        std::vector<Symbol> syms_after_dots() const;
+        void dump(std::ostream& os, const GammaArena& gammas) const;
     };
-
-    bool operator==(const ItemSet& lhs, const ItemSet& rhs);
 }
 
 #endif
@@ -3,6 +3,7 @@
 
 #include "pareas/lpg/parser/grammar.hpp"
 #include "pareas/lpg/parser/llp/admissible_pair.hpp"
+#include "pareas/lpg/cache.hpp"
 
 #include <vector>
 #include <unordered_map>
@@ -18,6 +19,12 @@ namespace pareas::parser::llp {
 
         std::unordered_map<AdmissiblePair, Entry, AdmissiblePair::Hash> table;
 
+        // Serialize this table for the generation cache. Symbols are stored by name, and productions by their
+        // index in `g`, which should be the grammar this table was generated from.
+        void save(CacheWriter& w, const Grammar& g) const;
+        // Deserialize a table stored by `save`, for a grammar parsed from the same source.
+        static ParsingTable load(CacheReader& r, const Grammar& g);
+
         void dump_csv(std::ostream& os);
     };
 }
@@ -7,17 +7,46 @@
 #include "pareas/lpg/parser/llp/parsing_table.hpp"
 
 #include <iosfwd>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <cstddef>
+#include <cstdint>
 
 namespace pareas::parser::llp {
+    // The tables of an LLP parser, encoded as they are consumed by the parser runtime.
+    struct ParserTables {
+        // A table of strings, stored as a superstring and the offset and length of the string of each pair
+        // of tokens, indexed by the token IDs of the pair. Pairs which don't have a string are set to -1.
+        struct StrTab {
+            size_t item_bytes;
+            std::vector<uint64_t> superstring;
+            std::vector<int32_t> offsets; // num_tokens * num_tokens
+            std::vector<int32_t> lengths; // num_tokens * num_tokens
+        };
+
+        size_t num_productions;
+        size_t production_bits;
+        size_t bracket_bits;
+
+        std::vector<int32_t> arities; // num_productions
+
+        // Operator list metadata, as used by src/compiler/parser/reassociate.fut. The role of each production in
+        // an operator list is encoded as the value of `OperatorListRole`. Productions of left-associative lists
+        // are given the 1-based index of the declaration of their list, and all other productions 0. These are
+        // empty if the grammar declares no operator lists.
+        std::vector<int32_t> operator_list_roles; // num_productions
+        std::vector<int32_t> left_assoc_lists; // num_productions
+        StrTab stack_change_table;
+        StrTab parse_table;
+
+        ParserTables(const TokenMapping& tm, const Grammar& g, const ParsingTable& pt);
+    };
+
     class ParserRenderer {
         Renderer* r;
-        const TokenMapping* tm;
         const Grammar* g;
-        const ParsingTable* pt;
-
-        std::unordered_map<Symbol, uint64_t, Symbol::Hash> symbol_mapping;
+        ParserTables tables;
 
     public:
         constexpr const static size_t TABLE_OFFSET_BITS = 32;
@@ -26,15 +55,15 @@ namespace pareas::parser::llp {
         void render() const;
 
     private:
-        uint64_t bracket_id(const Symbol& sym, bool left) const;
-        size_t bracket_backing_bits() const;
-
         void render_productions() const;
 
         void render_production_arity_data() const;
+        void render_operator_list_data() const;
 
         void render_stack_change_table() const;
         void render_parse_table() const;
+
+        void render_strtab(const ParserTables::StrTab& strtab, std::string_view name, std::string_view type) const;
     };
 }
 
@@ -0,0 +1,91 @@
+#ifndef _PAREAS_LPG_PARSER_LLP_SPAN_ARENA_HPP
+#define _PAREAS_LPG_PARSER_LLP_SPAN_ARENA_HPP
+
+#include "pareas/lpg/hash_util.hpp"
+
+#include <vector>
+#include <unordered_set>
+#include <span>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace pareas::parser::llp {
+    // Stores sequences of values back to back in a single vector, and assigns each distinct sequence a dense ID.
+    // Inserting a sequence equal to one that was inserted before yields the ID of the existing sequence, so each
+    // sequence is stored only once. The hash of a sequence is computed once, when it is inserted.
+    // The index refers back to the arena, so it can neither be copied nor moved.
+    template <typename T, typename Hash>
+    class SpanArena {
+    public:
+        using Id = uint32_t;
+
+    private:
+        struct Entry {
+            size_t offset;
+            size_t size;
+            size_t hash;
+        };
+
+        struct IdHash {
+            const SpanArena* arena;
+
+            size_t operator()(Id id) const {
+                return this->arena->entries[id].hash;
+            }
+        };
+
+        struct IdEqual {
+            const SpanArena* arena;
+
+            bool operator()(Id a, Id b) const {
+                auto lhs = (*this->arena)[a];
+                auto rhs = (*this->arena)[b];
+                return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+            }
+        };
+
+        std::vector<T> values;
+        std::vector<Entry> entries;
+        std::unordered_set<Id, IdHash, IdEqual> index;
+
+    public:
+        SpanArena():
+            index(0, IdHash{this}, IdEqual{this}) {}
+
+        SpanArena(const SpanArena&) = delete;
+        SpanArena& operator=(const SpanArena&) = delete;
+
+        // Returns the ID of the sequence, and whether it was newly inserted.
+        std::pair<Id, bool> insert(std::span<const T> span) {
+            // Tentatively append the sequence, so that the index can compare it against the existing ones.
+            auto id = static_cast<Id>(this->entries.size());
+            this->entries.push_back({
+                this->values.size(),
+                span.size(),
+                hash_range(span.begin(), span.end(), Hash{}),
+            });
+            this->values.insert(this->values.end(), span.begin(), span.end());
+
+            auto [it, inserted] = this->index.insert(id);
+            if (!inserted) {
+                this->values.erase(this->values.begin() + this->entries.back().offset, this->values.end());
+                this->entries.pop_back();
+            }
+
+            return {*it, inserted};
+        }
+
+        std::span<const T> operator[](Id id) const {
+            const auto& entry = this->entries[id];
+            return std::span(this->values).subspan(entry.offset, entry.size);
+        }
+
+        size_t size() const {
+            return this->entries.size();
+        }
+    };
+}
+
+#endif
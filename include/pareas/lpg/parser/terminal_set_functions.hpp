@@ -3,25 +3,85 @@
 
 #include "pareas/lpg/parser/grammar.hpp"
 
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 #include <span>
 #include <iosfwd>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
 
 namespace pareas::parser {
-    using TerminalSet = std::unordered_set<Terminal, Terminal::Hash>;
-    using TerminalSetMap = std::unordered_map<NonTerminal, TerminalSet, NonTerminal::Hash>;
+    // A set of terminals of a grammar, stored as a dense bitset indexed by terminal ID. Sets are sized to the
+    // number of terminals in the grammar's symbol table.
+    class TerminalSet {
+        using Word = uint64_t;
+        constexpr const static size_t WORD_BITS = 64;
+
+        const SymbolTable* symbols;
+        std::vector<Word> words;
+
+    public:
+        class Iterator {
+            const TerminalSet* set;
+            size_t id;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Terminal;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Terminal;
+
+            Iterator(const TerminalSet* set, size_t id);
+
+            Terminal operator*() const;
+            Iterator& operator++();
+            Iterator operator++(int);
+            bool operator==(const Iterator& other) const;
+
+        private:
+            // Advance `id` to the first terminal in the set at or after its current value.
+            void skip_to_next();
+        };
+
+        explicit TerminalSet(const SymbolTable* symbols);
+
+        // Returns whether the terminal was not yet in the set.
+        bool insert(const Terminal& t);
+        // Returns whether the terminal was in the set.
+        bool erase(const Terminal& t);
+        bool contains(const Terminal& t) const;
+
+        // Add all terminals of `other` to this set, optionally except for ε. Returns whether this set changed.
+        bool merge(const TerminalSet& other, bool omit_empty = false);
+
+        bool empty() const;
+        size_t size() const;
+
+        Iterator begin() const;
+        Iterator end() const;
+
+        bool operator==(const TerminalSet& other) const;
+    };
 
     bool merge_terminal_sets_omit_empty(TerminalSet& dst, const TerminalSet& src);
 
     struct TerminalSetFunctions {
-        ErrorReporter* er;
+        const Grammar* g;
+
+        // Indexed by non-terminal ID.
+        std::vector<TerminalSet> base_first_sets;
+        std::vector<TerminalSet> base_last_sets;
 
-        TerminalSetMap base_first_sets;
-        TerminalSetMap base_last_sets;
+        std::vector<TerminalSet> follow_sets;
+        std::vector<TerminalSet> before_sets;
 
-        TerminalSetMap follow_sets;
-        TerminalSetMap before_sets;
+        // The first set of every suffix and the last set of every prefix of the right hand side of every
+        // production, indexed by production ID and then by the offset at which the suffix starts or the
+        // length of the prefix. These are queried for every item while generating the parser, and are
+        // precomputed so that this object is immutable afterwards.
+        std::vector<std::vector<TerminalSet>> suffix_first_sets;
+        std::vector<std::vector<TerminalSet>> prefix_last_sets;
 
         TerminalSetFunctions(const Grammar& g);
 
@@ -31,14 +91,20 @@ namespace pareas::parser {
         const TerminalSet& follow(const NonTerminal& nt) const;
         const TerminalSet& before(const NonTerminal& nt) const;
 
+        // Equivalent to `compute_first(std::span(prod.rhs).subspan(offset))`.
+        const TerminalSet& first_of_suffix(const Production& prod, size_t offset) const;
+        // Equivalent to `compute_last(std::span(prod.rhs).subspan(0, len))`.
+        const TerminalSet& last_of_prefix(const Production& prod, size_t len) const;
+
         TerminalSet compute_first(std::span<const Symbol> symbols) const;
         TerminalSet compute_last(std::span<const Symbol> symbols) const;
 
         void dump(std::ostream& os);
 
     private:
-        TerminalSetMap compute_base_first_or_last_set(const Grammar& g, bool first) const;
-        TerminalSetMap compute_follow_or_before_sets(const Grammar& g, bool follow) const;
+        std::vector<TerminalSet> compute_base_first_or_last_set(bool first) const;
+        std::vector<std::vector<TerminalSet>> compute_affix_sets(bool first) const;
+        std::vector<TerminalSet> compute_follow_or_before_sets(bool follow) const;
 
         TerminalSet compute_first_or_last_set(std::span<const Symbol> symbols, bool first) const;
     };
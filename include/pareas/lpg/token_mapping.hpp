@@ -5,6 +5,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <iosfwd>
 #include <cstddef>
 
@@ -42,6 +43,9 @@ namespace pareas {
         size_t token_id(const Token& token) const;
         size_t num_tokens() const;
 
+        // Returns the tokens in order of their ID.
+        std::vector<const Token*> ordered_tokens() const;
+
         void render(Renderer& r) const;
     };
 }
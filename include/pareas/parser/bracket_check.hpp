@@ -0,0 +1,24 @@
+#ifndef _PAREAS_PARSER_BRACKET_CHECK_HPP
+#define _PAREAS_PARSER_BRACKET_CHECK_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace pareas::parser {
+    // Compute the maximum number of bits of the bracket nesting depth for which the brackets are checked by
+    // sorting them by depth, rather than by looking up the mate of each bracket in a binary tree. Every two
+    // bits of depth add a pass of the radix sort over all brackets, while lookups in the binary tree get
+    // more expensive as the number of brackets grows. These constants are rough estimates, and have not yet
+    // been measured: they should be calibrated using the depth sweep in src/compiler/parser/bench_brackets.fut.
+    // This heuristic is shared by all drivers which use the parser in src/compiler/parser/parser.fut.
+    constexpr int32_t auto_radix_max_bits(size_t num_tokens) {
+        constexpr int32_t BASE_RADIX_BITS = 4;
+        constexpr int32_t TREE_LEVELS_PER_RADIX_BIT = 4;
+
+        auto tree_levels = static_cast<int32_t>(std::bit_width(num_tokens));
+        return BASE_RADIX_BITS + tree_levels / TREE_LEVELS_PER_RADIX_BIT;
+    }
+}
+
+#endif
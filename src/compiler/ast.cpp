@@ -6,6 +6,8 @@
 
 #include <utility>
 
+using IndexTraits = futhark::ArrayTraits<futhark::Index, 1>;
+
 const char* data_type_name(DataType dt) {
     switch (dt) {
         case DataType::INVALID: return "invalid";
@@ -120,7 +122,7 @@ DeviceAst::~DeviceAst() {
         futhark_free_u8_1d(this->ctx, this->node_types);
 
     if (this->parents)
-        futhark_free_i32_1d(this->ctx, this->parents);
+        IndexTraits::free_fn(this->ctx, this->parents);
 
     if (this->node_data)
         futhark_free_u32_1d(this->ctx, this->node_data);
@@ -129,10 +131,10 @@ DeviceAst::~DeviceAst() {
         futhark_free_u8_1d(this->ctx, this->data_types);
 
     if (this->node_depths)
-        futhark_free_i32_1d(this->ctx, this->node_depths);
+        IndexTraits::free_fn(this->ctx, this->node_depths);
 
     if (this->child_indexes)
-        futhark_free_i32_1d(this->ctx, this->child_indexes);
+        IndexTraits::free_fn(this->ctx, this->child_indexes);
 
     if (this->fn_tab)
         futhark_free_u32_1d(this->ctx, this->fn_tab);
@@ -158,11 +160,11 @@ HostAst DeviceAst::download() const {
         .num_nodes = num_nodes,
         .num_functions = num_functions,
         .node_types = std::make_unique<grammar::Production[]>(num_nodes),
-        .parents = std::make_unique<int32_t[]>(num_nodes),
+        .parents = std::make_unique<futhark::Index[]>(num_nodes),
         .node_data = std::make_unique<uint32_t[]>(num_nodes),
         .data_types = std::make_unique<DataType[]>(num_nodes),
-        .node_depths = std::make_unique<int32_t[]>(num_nodes),
-        .child_indexes = std::make_unique<int32_t[]>(num_nodes),
+        .node_depths = std::make_unique<futhark::Index[]>(num_nodes),
+        .child_indexes = std::make_unique<futhark::Index[]>(num_nodes),
         .fn_tab = std::make_unique<uint32_t[]>(num_functions)
     };
 
@@ -172,7 +174,7 @@ HostAst DeviceAst::download() const {
         reinterpret_cast<std::underlying_type_t<grammar::Production>*>(ast.node_types.get())
     );
 
-    err |= futhark_values_i32_1d(this->ctx, this->parents, ast.parents.get());
+    err |= IndexTraits::values_fn(this->ctx, this->parents, ast.parents.get());
     err |= futhark_values_u32_1d(this->ctx, this->node_data, ast.node_data.get());
 
     err |= futhark_values_u8_1d(
@@ -181,8 +183,8 @@ HostAst DeviceAst::download() const {
         reinterpret_cast<std::underlying_type_t<DataType>*>(ast.data_types.get())
     );
 
-    err |= futhark_values_i32_1d(this->ctx, this->node_depths, ast.node_depths.get());
-    err |= futhark_values_i32_1d(this->ctx, this->child_indexes, ast.child_indexes.get());
+    err |= IndexTraits::values_fn(this->ctx, this->node_depths, ast.node_depths.get());
+    err |= IndexTraits::values_fn(this->ctx, this->child_indexes, ast.child_indexes.get());
 
     err |= futhark_values_u32_1d(this->ctx, this->fn_tab, ast.fn_tab.get());
 
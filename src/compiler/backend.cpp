@@ -6,7 +6,7 @@
 #include <iostream>
 
 namespace backend {
-    DeviceModule compile(futhark_context* ctx, DeviceAst& ast, pareas::Profiler& p) {
+    DeviceModule compile(futhark_context* ctx, DeviceAst& ast, RegAlloc regalloc, bool verbose, pareas::Profiler& p) {
         auto tree = futhark::UniqueTree(ctx);
         p.measure("translate ast", [&] {
             int err = futhark_entry_backend_convert_tree(
@@ -104,6 +104,7 @@ namespace backend {
         });
 
         // Stage 5-6, regalloc + instr remove
+        int64_t spills, weighted_spills;
         p.measure("regalloc/instr remove", [&] {
             auto old_instr = std::move(instr);
             auto old_functab = std::move(functab);
@@ -112,15 +113,23 @@ namespace backend {
                 ctx,
                 &instr,
                 &functab,
+                &spills,
+                &weighted_spills,
                 old_instr,
                 old_functab,
                 ast.fn_tab,
-                optimize
+                optimize,
+                regalloc == RegAlloc::LINEAR_SCAN
             );
             if(err)
                 throw futhark::Error(ctx);
         });
 
+        if (verbose) {
+            fmt::print(std::cerr, "Spill loads/stores: {}\n", spills);
+            fmt::print(std::cerr, "Estimated executed spill loads/stores: {}\n", weighted_spills);
+        }
+
         // Stage 7, jump fix
         auto mod = DeviceModule(ctx);
         p.measure("jump fix", [&] {
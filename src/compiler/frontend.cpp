@@ -1,5 +1,6 @@
 #include "pareas/compiler/frontend.hpp"
 #include "pareas/compiler/futhark_interop.hpp"
+#include "pareas/parser/bracket_check.hpp"
 
 #include "pareas_grammar.hpp"
 
@@ -7,20 +8,23 @@
 #include <fmt/chrono.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
 
 namespace {
     futhark::UniqueLexTable upload_lex_table(futhark_context* ctx) {
-        auto initial_state = futhark::UniqueArray<uint16_t, 1>(
+        // The width of a lexer state depends on the grammar, so the tables are uploaded as bytes.
+        auto initial_state = futhark::UniqueArray<uint8_t, 1>(
             ctx,
-            reinterpret_cast<const grammar::LexTable::State*>(grammar::lex_table.initial_states),
-            grammar::LexTable::NUM_INITIAL_STATES
+            reinterpret_cast<const uint8_t*>(grammar::lex_table.initial_states),
+            grammar::LexTable::NUM_INITIAL_STATES * sizeof(grammar::LexTable::State)
         );
 
-        auto merge_table = futhark::UniqueArray<uint16_t, 2>(
+        auto merge_table = futhark::UniqueArray<uint8_t, 1>(
             ctx,
-            reinterpret_cast<const grammar::LexTable::State*>(grammar::lex_table.merge_table),
-            grammar::lex_table.n,
-            grammar::lex_table.n
+            reinterpret_cast<const uint8_t*>(grammar::lex_table.merge_table),
+            grammar::lex_table.n * grammar::lex_table.n * sizeof(grammar::LexTable::State)
         );
 
         auto final_state = futhark::UniqueArray<uint8_t, 1>(
@@ -66,6 +70,42 @@ namespace {
 
         return tab;
     }
+
+    // Compute the maximum number of bits of the bracket nesting depth for which the brackets are checked by
+    // sorting them by depth, see `pareas::parser::auto_radix_max_bits`.
+    int32_t radix_max_bits(frontend::BracketCheck bracket_check, futhark::Index num_tokens) {
+        switch (bracket_check) {
+            case frontend::BracketCheck::BINARY_TREE: return -1;
+            case frontend::BracketCheck::RADIX: return 32;
+            case frontend::BracketCheck::AUTO: break;
+        }
+
+        return pareas::parser::auto_radix_max_bits(static_cast<size_t>(num_tokens));
+    }
+
+    // The stack change table and parse table are only used together, so upload them as
+    // a single table of which the references are interleaved.
+    futhark::UniqueFusedParseTable upload_fused_parse_table(futhark_context* ctx) {
+        auto sct = upload_strtab<futhark::UniqueStackChangeTable>(
+            ctx,
+            grammar::stack_change_table,
+            futhark_entry_mk_stack_change_table
+        );
+
+        auto pt = upload_strtab<futhark::UniqueParseTable>(
+            ctx,
+            grammar::parse_table,
+            futhark_entry_mk_parse_table
+        );
+
+        auto fpt = futhark::UniqueFusedParseTable(ctx);
+
+        int err = futhark_entry_mk_fused_parse_table(ctx, &fpt, sct, pt);
+        if (err)
+            throw futhark::Error(ctx);
+
+        return fpt;
+    }
 }
 
 namespace frontend {
@@ -83,31 +123,38 @@ namespace frontend {
             case Error::TYPE_ERROR: return "Type error";
             case Error::INVALID_RETURN: return "Return expression has invalid type";
             case Error::MISSING_RETURN: return "Not all code paths in non-void function return a value";
+            case Error::UNKNOWN_ROOT: return "No function named by root";
+            case Error::INPUT_TOO_LARGE: return "Input too large for the configured index width";
         }
     }
 
-    DeviceAst compile(futhark_context* ctx, const std::string& input, bool verbose_tree, pareas::Profiler& p, std::FILE* debug_log) {
+    DeviceAst compile(
+        futhark_context* ctx,
+        const std::string& input,
+        const std::vector<std::string_view>& roots,
+        int32_t inline_budget,
+        BracketCheck bracket_check,
+        int32_t compact_threshold,
+        bool verbose_tree,
+        pareas::Profiler& p,
+        std::FILE* debug_log
+    ) {
         auto debug_log_region = [&](const char* name) {
             if (debug_log)
                 fmt::print(debug_log, "<<<{}>>>\n", name);
         };
 
+        // The compiler passes index the input, tokens and nodes with `futhark::Index`, see the `index-bits`
+        // option, so refuse inputs that would overflow it.
+        constexpr auto max_index = static_cast<size_t>(std::numeric_limits<futhark::Index>::max());
+        if (input.size() > max_index)
+            throw CompileError(Error::INPUT_TOO_LARGE);
+
         debug_log_region("upload");
         p.begin();
         p.begin();
         auto lex_table = upload_lex_table(ctx);
-        auto sct = upload_strtab<futhark::UniqueStackChangeTable>(
-            ctx,
-            grammar::stack_change_table,
-            futhark_entry_mk_stack_change_table
-        );
-
-        auto pt = upload_strtab<futhark::UniqueParseTable>(
-            ctx,
-            grammar::parse_table,
-            futhark_entry_mk_parse_table
-        );
-
+        auto fpt = upload_fused_parse_table(ctx);
         auto arity_array = futhark::UniqueArray<int32_t, 1>(ctx, grammar::arities, grammar::NUM_PRODUCTIONS);
         p.end("table");
         p.begin();
@@ -125,33 +172,38 @@ namespace frontend {
             if (err)
                 throw futhark::Error(ctx);
         });
-        lex_table.clear();
+
+        futhark::Index num_tokens;
+        if (futhark_entry_frontend_num_tokens(ctx, &num_tokens, tokens))
+            throw futhark::Error(ctx);
+        auto bracket_radix_max_bits = radix_max_bits(bracket_check, num_tokens);
 
         if (verbose_tree) {
-            int32_t result;
-            futhark_entry_frontend_num_tokens(ctx, &result, tokens);
-            fmt::print(std::cerr, "Tokens: {}\n", result);
+            fmt::print(std::cerr, "Tokens: {}\n", num_tokens);
+            fmt::print(std::cerr, "Max bracket depth bits for radix sort check: {}\n", bracket_radix_max_bits);
         }
 
         debug_log_region("parse");
         auto node_types = futhark::UniqueArray<uint8_t, 1>(ctx);
         p.measure("parse", [&]{
             bool valid = false;
-            int err = futhark_entry_frontend_parse(ctx, &valid, &node_types, tokens, sct, pt);
+            int err = futhark_entry_frontend_parse(ctx, &valid, &node_types, tokens, fpt, bracket_radix_max_bits);
             if (err)
                 throw futhark::Error(ctx);
             if (!valid)
                 throw CompileError(Error::PARSE_ERROR);
         });
-        sct.clear();
-        pt.clear();
+        fpt.clear();
+
+        if (static_cast<size_t>(node_types.shape()[0]) > max_index)
+            throw CompileError(Error::INPUT_TOO_LARGE);
 
         if (verbose_tree) {
             fmt::print(std::cerr, "Initial nodes: {}\n", node_types.shape()[0]);
         }
 
         debug_log_region("build parse tree");
-        auto parents = futhark::UniqueArray<int32_t, 1>(ctx);
+        auto parents = futhark::UniqueArray<futhark::Index, 1>(ctx);
         p.measure("build parse tree", [&]{
             int err = futhark_entry_frontend_build_parse_tree(ctx, &parents, node_types, arity_array);
             if (err)
@@ -160,6 +212,34 @@ namespace frontend {
         arity_array.clear();
 
 
+        // Most syntax passes mark removed nodes by letting them point to themselves, after which they are
+        // only removed from the arrays when computing the prev siblings. If many nodes are removed early,
+        // compactify the tree right away so that the remaining passes don't need to process them.
+        auto compactify_if_sparse = [&](const char* pass) {
+            if (compact_threshold < 0)
+                return;
+
+            futhark::Index removed;
+            if (futhark_entry_frontend_num_removed_nodes(ctx, &removed, parents))
+                throw futhark::Error(ctx);
+
+            int64_t nodes = parents.shape()[0];
+            if (removed == 0 || static_cast<int64_t>(removed) * 100 < int64_t{compact_threshold} * nodes)
+                return;
+
+            p.measure("compactify", [&]{
+                auto old_node_types = std::move(node_types);
+                auto old_parents = std::move(parents);
+                int err = futhark_entry_frontend_compactify_nodes(ctx, &node_types, &parents, old_node_types, old_parents);
+                if (err)
+                    throw futhark::Error(ctx);
+            });
+
+            if (verbose_tree) {
+                fmt::print(std::cerr, "Compactified after {}: {} -> {} nodes\n", pass, nodes, node_types.shape()[0]);
+            }
+        };
+
         p.begin();
         debug_log_region("syntax");
         p.measure("fix bin ops", [&]{
@@ -184,6 +264,7 @@ namespace frontend {
             if (!valid)
                 throw CompileError(Error::STRAY_ELSE_ERROR);
         });
+        compactify_if_sparse("fix conditionals");
 
         p.measure("flatten lists", [&]{
             auto old_node_types = std::move(node_types);
@@ -192,6 +273,7 @@ namespace frontend {
             if (err)
                 throw futhark::Error(ctx);
         });
+        compactify_if_sparse("flatten lists");
 
         p.measure("fix names", [&]{
             auto old_node_types = std::move(node_types);
@@ -203,6 +285,7 @@ namespace frontend {
             if (!valid)
                 throw CompileError(Error::INVALID_DECL);
         });
+        compactify_if_sparse("fix names");
 
         p.measure("fix ascriptions", [&]{
             auto old_parents = std::move(parents);
@@ -210,6 +293,7 @@ namespace frontend {
             if (err)
                 throw futhark::Error(ctx);
         });
+        compactify_if_sparse("fix ascriptions");
 
         p.measure("fix fn decls", [&]{
             auto old_parents = std::move(parents);
@@ -220,6 +304,7 @@ namespace frontend {
             if (!valid)
                 throw CompileError(Error::INVALID_FN_PROTO);
         });
+        compactify_if_sparse("fix fn decls");
 
         p.measure("fix args and params", [&]{
             auto old_node_types = std::move(node_types);
@@ -238,6 +323,7 @@ namespace frontend {
             if (!valid)
                 throw CompileError(Error::INVALID_DECL);
         });
+        compactify_if_sparse("fix decls");
 
         p.measure("remove marker nodes", [&]{
             auto old_parents = std::move(parents);
@@ -246,7 +332,7 @@ namespace frontend {
                 throw futhark::Error(ctx);
         });
 
-        auto prev_siblings = futhark::UniqueArray<int32_t, 1>(ctx);
+        auto prev_siblings = futhark::UniqueArray<futhark::Index, 1>(ctx);
         p.measure("compute prev siblings", [&]{
             auto old_node_types = std::move(node_types);
             auto old_parents = std::move(parents);
@@ -278,16 +364,67 @@ namespace frontend {
 
         auto node_data = futhark::UniqueArray<uint32_t, 1>(ctx);
         p.measure("extract lexemes", [&]{
-            int err = futhark_entry_frontend_extract_lexemes(ctx, &node_data, input_array, tokens, node_types);
+            int err = futhark_entry_frontend_extract_lexemes(ctx, &node_data, input_array, lex_table, tokens, node_types);
             if (err)
                 throw futhark::Error(ctx);
         });
+
+        // Look up the name IDs of the root functions while the node order still matches the token order.
+        auto root_ids = futhark::UniqueArray<uint32_t, 1>(ctx);
+        if (!roots.empty()) {
+            p.measure("find roots", [&]{
+                auto names = std::string();
+                auto offsets = std::vector<futhark::Index>();
+                auto lengths = std::vector<futhark::Index>();
+                for (const auto& root : roots) {
+                    offsets.push_back(names.size());
+                    lengths.push_back(root.size());
+                    names += root;
+                }
+
+                auto names_array = futhark::UniqueArray<uint8_t, 1>(ctx, reinterpret_cast<const uint8_t*>(names.data()), names.size());
+                auto offsets_array = futhark::UniqueArray<futhark::Index, 1>(ctx, offsets.data(), offsets.size());
+                auto lengths_array = futhark::UniqueArray<futhark::Index, 1>(ctx, lengths.data(), lengths.size());
+                int err = futhark_entry_frontend_find_name_ids(
+                    ctx,
+                    &root_ids,
+                    input_array,
+                    lex_table,
+                    tokens,
+                    node_types,
+                    node_data,
+                    names_array,
+                    offsets_array,
+                    lengths_array
+                );
+                if (err)
+                    throw futhark::Error(ctx);
+            });
+        }
         input_array.clear();
+        lex_table.clear();
+
+        // Structural information about the tree, such as the depth and next sibling of each node, which is
+        // shared between passes. It is only valid for the current shape of the tree, so it is cleared by every
+        // pass which changes the shape, and rebuilt by the next pass which needs it.
+        auto tree_index = futhark::UniqueTreeIndex(ctx);
+        auto build_tree_index = [&]{
+            if (tree_index.get())
+                return;
+
+            p.measure("build tree index", [&]{
+                int err = futhark_entry_frontend_build_tree_index(ctx, &tree_index, parents, prev_siblings);
+                if (err)
+                    throw futhark::Error(ctx);
+            });
+        };
+
+        build_tree_index();
 
-        auto resolution = futhark::UniqueArray<int32_t, 1>(ctx);
+        auto resolution = futhark::UniqueArray<futhark::Index, 1>(ctx);
         p.measure("resolve vars", [&]{
             bool valid;
-            int err = futhark_entry_frontend_resolve_vars(ctx, &valid, &resolution, node_types, parents, prev_siblings, node_data);
+            int err = futhark_entry_frontend_resolve_vars(ctx, &valid, &resolution, node_types, parents, prev_siblings, tree_index, node_data);
             if (err)
                 throw futhark::Error(ctx);
             if (!valid)
@@ -307,7 +444,7 @@ namespace frontend {
         p.measure("resolve args", [&]{
             auto old_resolution = std::move(resolution);
             bool valid;
-            int err = futhark_entry_frontend_resolve_args(ctx, &valid, &resolution, node_types, parents, prev_siblings, old_resolution);
+            int err = futhark_entry_frontend_resolve_args(ctx, &valid, &resolution, node_types, parents, prev_siblings, tree_index, old_resolution);
             if (err)
                 throw futhark::Error(ctx);
             if (!valid)
@@ -317,7 +454,7 @@ namespace frontend {
         auto data_types = futhark::UniqueArray<uint8_t, 1>(ctx);
         p.measure("resolve dtypes", [&]{
             bool valid;
-            int err = futhark_entry_frontend_resolve_data_types(ctx, &valid, &data_types, node_types, parents, prev_siblings, resolution.get());
+            int err = futhark_entry_frontend_resolve_data_types(ctx, &valid, &data_types, node_types, parents, prev_siblings, tree_index, resolution.get());
             if (err)
                 throw futhark::Error(ctx);
             if (!valid)
@@ -335,13 +472,129 @@ namespace frontend {
 
         p.measure("check convergence", [&]{
             bool valid;
-            int err = futhark_entry_frontend_check_convergence(ctx, &valid, node_types, parents, prev_siblings);
+            int err = futhark_entry_frontend_check_convergence(ctx, &valid, node_types, parents, tree_index);
             if (err)
                 throw futhark::Error(ctx);
             if (!valid)
                 throw CompileError(Error::MISSING_RETURN);
         });
 
+        if (inline_budget > 0) {
+            futhark::Index num_inlined;
+            p.measure("inline calls", [&]{
+                auto old_node_types = std::move(node_types);
+                auto old_parents = std::move(parents);
+                auto old_prev_siblings = std::move(prev_siblings);
+                auto old_node_data = std::move(node_data);
+                auto old_data_types = std::move(data_types);
+                auto old_resolution = std::move(resolution);
+                int err = futhark_entry_frontend_inline_calls(
+                    ctx,
+                    &num_inlined,
+                    &node_types,
+                    &parents,
+                    &prev_siblings,
+                    &node_data,
+                    &data_types,
+                    &resolution,
+                    inline_budget,
+                    old_node_types,
+                    old_parents,
+                    old_prev_siblings,
+                    tree_index,
+                    old_node_data,
+                    old_data_types,
+                    old_resolution
+                );
+                if (err)
+                    throw futhark::Error(ctx);
+            });
+            tree_index.clear();
+
+            if (verbose_tree) {
+                fmt::print(std::cerr, "Inlined calls: {}\n", num_inlined);
+                fmt::print(std::cerr, "Nodes after inlining: {}\n", node_types.shape()[0]);
+            }
+        }
+
+        build_tree_index();
+        p.measure("fold constants", [&]{
+            auto old_node_types = std::move(node_types);
+            auto old_parents = std::move(parents);
+            auto old_prev_siblings = std::move(prev_siblings);
+            auto old_node_data = std::move(node_data);
+            auto old_data_types = std::move(data_types);
+            auto old_resolution = std::move(resolution);
+            int err = futhark_entry_frontend_fold_constants(
+                ctx,
+                &node_types,
+                &parents,
+                &prev_siblings,
+                &node_data,
+                &data_types,
+                &resolution,
+                old_node_types,
+                old_parents,
+                old_prev_siblings,
+                tree_index,
+                old_node_data,
+                old_data_types,
+                old_resolution
+            );
+            if (err)
+                throw futhark::Error(ctx);
+        });
+        tree_index.clear();
+
+        if (verbose_tree) {
+            fmt::print(std::cerr, "Nodes after constant folding: {}\n", node_types.shape()[0]);
+        }
+
+        if (!roots.empty()) {
+            p.measure("remove dead fns", [&]{
+                auto old_node_types = std::move(node_types);
+                auto old_parents = std::move(parents);
+                auto old_prev_siblings = std::move(prev_siblings);
+                auto old_node_data = std::move(node_data);
+                auto old_data_types = std::move(data_types);
+                auto old_resolution = std::move(resolution);
+                auto roots_found = futhark::UniqueArray<bool, 1>(ctx);
+                int err = futhark_entry_frontend_remove_dead_fns(
+                    ctx,
+                    &roots_found,
+                    &node_types,
+                    &parents,
+                    &prev_siblings,
+                    &node_data,
+                    &data_types,
+                    &resolution,
+                    old_node_types,
+                    old_parents,
+                    old_prev_siblings,
+                    old_node_data,
+                    old_data_types,
+                    old_resolution,
+                    root_ids
+                );
+                if (err)
+                    throw futhark::Error(ctx);
+
+                // Otherwise, no function would be reachable from that root, which is almost certainly a mistake.
+                auto found = std::make_unique<bool[]>(roots.size());
+                roots_found.values(found.get());
+                for (size_t i = 0; i < roots.size(); ++i) {
+                    if (!found[i])
+                        throw CompileError(Error::UNKNOWN_ROOT, roots[i]);
+                }
+            });
+            tree_index.clear();
+
+            if (verbose_tree) {
+                fmt::print(std::cerr, "Nodes after removing dead functions: {}\n", node_types.shape()[0]);
+            }
+        }
+
+        build_tree_index();
         auto ast = DeviceAst(ctx);
         p.measure("build ast", [&]{
             // Other arrays are destructed at the end of the function.
@@ -359,7 +612,8 @@ namespace frontend {
                 node_data,
                 data_types,
                 prev_siblings,
-                resolution
+                resolution,
+                tree_index
             );
             if (err)
                 throw futhark::Error(ctx);
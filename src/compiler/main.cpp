@@ -15,6 +15,7 @@
 #include <iostream>
 #include <fstream>
 #include <string_view>
+#include <vector>
 #include <memory>
 #include <chrono>
 #include <charconv>
@@ -33,6 +34,11 @@ struct Options {
     bool dump_dot;
     unsigned profile;
     bool check;
+    std::vector<std::string_view> roots;
+    int32_t inline_budget;
+    frontend::BracketCheck bracket_check;
+    int32_t compact_threshold;
+    backend::RegAlloc regalloc;
     bool verbose_tree;
     bool verbose_mod;
     bool futhark_verbose;
@@ -68,9 +74,23 @@ void print_usage(char* progname) {
         "-p --profile <level>        Record (non-futhark) profiling information.\n"
         "--check                     Only run check the program for validity; do not\n"
         "                            attempt to generate code.\n"
+        "-r --root <name>            Only emit functions reachable from function <name>.\n"
+        "                            May be given multiple times. (default: emit all\n"
+        "                            functions)\n"
+        "--inline-budget <nodes>     Inline calls to leaf functions of which the return\n"
+        "                            expression has at most <nodes> nodes. 0 disables\n"
+        "                            inlining. (default: 16)\n"
+        "--bracket-check <algorithm> Select how brackets are matched while parsing:\n"
+        "                            'auto', 'tree' or 'radix'. (default: auto)\n"
+        "--compact-threshold <pct>   Compactify the tree between syntax passes as soon\n"
+        "                            as at least <pct> percent of its nodes are removed.\n"
+        "                            'off' only compactifies at fixed points in the\n"
+        "                            pipeline. (default: 25)\n"
+        "--regalloc <allocator>      Select the register allocator: 'greedy' or\n"
+        "                            'linear-scan'. (default: greedy)\n"
         "--verbose-tree              Dump some information about the tree to stderr.\n"
         "--verbose-mod               Dump some information about the final module to\n"
-        "                            stderr.\n"
+        "                            stderr, including spill statistics.\n"
         "--futhark-verbose           Enable Futhark logging.\n"
         "--futhark-debug             Enable Futhark debug logging.\n"
         "--futhark-debug-extra       Futhark debug logging with extra information.\n"
@@ -112,6 +132,11 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
         .dump_dot = false,
         .profile = 0,
         .check = false,
+        .roots = {},
+        .inline_budget = 16,
+        .bracket_check = frontend::BracketCheck::AUTO,
+        .compact_threshold = 25,
+        .regalloc = backend::RegAlloc::GREEDY,
         .verbose_tree = false,
         .verbose_mod = false,
         .futhark_verbose = false,
@@ -124,6 +149,8 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
     };
 
     const char* threads_arg = nullptr;
+    const char* inline_budget_arg = nullptr;
+    const char* compact_threshold_arg = nullptr;
     const char* profile_arg = nullptr;
 
     for (int i = 1; i < argc; ++i) {
@@ -176,6 +203,59 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
             profile_arg = argv[i];
         } else if (arg == "--check") {
             opts->check = true;
+        } else if (arg == "-r" || arg == "--root") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <name> to option {}\n", arg);
+                return false;
+            }
+
+            opts->roots.push_back(argv[i]);
+        } else if (arg == "--inline-budget") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <nodes> to option {}\n", arg);
+                return false;
+            }
+
+            inline_budget_arg = argv[i];
+        } else if (arg == "--bracket-check") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <algorithm> to option {}\n", arg);
+                return false;
+            }
+
+            auto bracket_check = std::string_view(argv[i]);
+            if (bracket_check == "auto") {
+                opts->bracket_check = frontend::BracketCheck::AUTO;
+            } else if (bracket_check == "tree") {
+                opts->bracket_check = frontend::BracketCheck::BINARY_TREE;
+            } else if (bracket_check == "radix") {
+                opts->bracket_check = frontend::BracketCheck::RADIX;
+            } else {
+                fmt::print(std::cerr, "Error: Invalid value '{}' for option --bracket-check\n", bracket_check);
+                return false;
+            }
+        } else if (arg == "--compact-threshold") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <pct> to option {}\n", arg);
+                return false;
+            }
+
+            compact_threshold_arg = argv[i];
+        } else if (arg == "--regalloc") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <allocator> to option {}\n", arg);
+                return false;
+            }
+
+            auto regalloc = std::string_view(argv[i]);
+            if (regalloc == "greedy") {
+                opts->regalloc = backend::RegAlloc::GREEDY;
+            } else if (regalloc == "linear-scan") {
+                opts->regalloc = backend::RegAlloc::LINEAR_SCAN;
+            } else {
+                fmt::print(std::cerr, "Error: Invalid value '{}' for option --regalloc\n", regalloc);
+                return false;
+            }
         } else if (arg == "--verbose-tree") {
             opts->verbose_tree = true;
         } else if (arg == "--verbose-mod") {
@@ -222,6 +302,28 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
         }
     }
 
+    if (inline_budget_arg) {
+        const auto* end = inline_budget_arg + std::strlen(inline_budget_arg);
+        auto [p, ec] = std::from_chars(inline_budget_arg, end, opts->inline_budget);
+        if (ec != std::errc() || p != end || opts->inline_budget < 0) {
+            fmt::print(std::cerr, "Error: Invalid value '{}' for option --inline-budget\n", inline_budget_arg);
+            return false;
+        }
+    }
+
+    if (compact_threshold_arg) {
+        const auto* end = compact_threshold_arg + std::strlen(compact_threshold_arg);
+        if (std::string_view(compact_threshold_arg) == "off") {
+            opts->compact_threshold = -1;
+        } else {
+            auto [p, ec] = std::from_chars(compact_threshold_arg, end, opts->compact_threshold);
+            if (ec != std::errc() || p != end || opts->compact_threshold < 0 || opts->compact_threshold > 100) {
+                fmt::print(std::cerr, "Error: Invalid value '{}' for option --compact-threshold\n", compact_threshold_arg);
+                return false;
+            }
+        }
+    }
+
     if (profile_arg) {
         const auto* end = profile_arg + std::strlen(profile_arg);
         auto [p, ec] = std::from_chars(profile_arg, end, opts->profile);
@@ -365,7 +467,7 @@ int main(int argc, char* argv[]) {
 
     try {
         p.begin();
-        auto ast = frontend::compile(ctx.get(), input, opts.verbose_tree, p, opts.futhark_debug_extra ? stderr : nullptr);
+        auto ast = frontend::compile(ctx.get(), input, opts.roots, opts.inline_budget, opts.bracket_check, opts.compact_threshold, opts.verbose_tree, p, opts.futhark_debug_extra ? stderr : nullptr);
         p.end("frontend");
 
         if (opts.dump_dot) {
@@ -377,7 +479,7 @@ int main(int argc, char* argv[]) {
 
         if (!opts.check) {
             p.begin();
-            auto module = backend::compile(ctx.get(), ast, p);
+            auto module = backend::compile(ctx.get(), ast, opts.regalloc, opts.verbose_mod, p);
             p.end("backend");
 
             auto host_mod = module.download();
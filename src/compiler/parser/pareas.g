@@ -31,6 +31,18 @@ stat_list -> stat stat_list;
 stat_list [stat_list_end] -> ;
 
 ## Expressions
+# The binary operators are parsed as right-recursive lists, which are restructured into expression trees after
+# parsing (see src/compiler/passes/fix_bin_ops.fut). These declarations mark which lists that applies to, from lowest
+# to highest precedence.
+%right assign;
+%left logical_or;
+%left logical_and;
+%left rela;
+%left bitwise;
+%left shift;
+%left sum;
+%left prod;
+
 # By making the LHS of this production the same as that of `expr`, we can ignore it further,
 # and simply handle no_expr when type checking.
 maybe_expr [expr_] -> ascript assign;
@@ -0,0 +1,287 @@
+#include "pareas/generic/bundle.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <utility>
+#include <bit>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    using namespace pareas;
+
+    const char* section_name(bundle::SectionId id) {
+        switch (id) {
+            case bundle::SectionId::GRAMMAR_INFO: return "grammar info";
+            case bundle::SectionId::TOKEN_NAMES: return "token names";
+            case bundle::SectionId::LEXER_INITIAL_STATES: return "lexer initial states";
+            case bundle::SectionId::LEXER_MERGE_TABLE: return "lexer merge table";
+            case bundle::SectionId::LEXER_FINAL_STATES: return "lexer final states";
+            case bundle::SectionId::PRODUCTION_NAMES: return "production names";
+            case bundle::SectionId::PRODUCTION_ARITIES: return "production arities";
+            case bundle::SectionId::STACK_CHANGE_TABLE: return "stack change table";
+            case bundle::SectionId::STACK_CHANGE_OFFSETS: return "stack change offsets";
+            case bundle::SectionId::STACK_CHANGE_LENGTHS: return "stack change lengths";
+            case bundle::SectionId::PARSE_TABLE: return "parse table";
+            case bundle::SectionId::PARSE_OFFSETS: return "parse offsets";
+            case bundle::SectionId::PARSE_LENGTHS: return "parse lengths";
+            case bundle::SectionId::OPERATOR_LIST_ROLES: return "operator list roles";
+            case bundle::SectionId::LEFT_ASSOC_LISTS: return "left-associative lists";
+        }
+
+        return "unknown";
+    }
+
+    uint32_t read_u32(const uint8_t* ptr) {
+        uint32_t value;
+        std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+}
+
+namespace pareas::generic {
+    Bundle::Bundle(const char* path):
+        data(nullptr), size(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            throw BundleError(fmt::format("Failed to open bundle '{}': {}", path, std::strerror(errno)));
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            auto err = errno;
+            close(fd);
+            throw BundleError(fmt::format("Failed to stat bundle '{}': {}", path, std::strerror(err)));
+        }
+
+        this->size = static_cast<size_t>(st.st_size);
+        if (this->size < sizeof(bundle::Header)) {
+            close(fd);
+            throw BundleError(fmt::format("Bundle '{}' is too small", path));
+        }
+
+        void* map = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        auto err = errno;
+        close(fd);
+
+        if (map == MAP_FAILED) {
+            throw BundleError(fmt::format("Failed to map bundle '{}': {}", path, std::strerror(err)));
+        }
+
+        this->data = static_cast<const uint8_t*>(map);
+
+        // The destructor does not run if the constructor throws, so the mapping needs to be released here.
+        try {
+            this->validate();
+        } catch (const BundleError& e) {
+            munmap(map, this->size);
+            throw BundleError(fmt::format("Invalid bundle '{}': {}", path, e.what()));
+        } catch (...) {
+            munmap(map, this->size);
+            throw;
+        }
+    }
+
+    Bundle::~Bundle() {
+        if (this->data)
+            munmap(const_cast<uint8_t*>(this->data), this->size);
+    }
+
+    Bundle::Bundle(Bundle&& other):
+        data(std::exchange(other.data, nullptr)),
+        size(std::exchange(other.size, 0)),
+        grammar_info(other.grammar_info),
+        sections(std::move(other.sections)),
+        token_names(std::move(other.token_names)),
+        production_names(std::move(other.production_names)) {
+    }
+
+    Bundle& Bundle::operator=(Bundle&& other) {
+        std::swap(this->data, other.data);
+        std::swap(this->size, other.size);
+        std::swap(this->grammar_info, other.grammar_info);
+        std::swap(this->sections, other.sections);
+        std::swap(this->token_names, other.token_names);
+        std::swap(this->production_names, other.production_names);
+        return *this;
+    }
+
+    const bundle::GrammarInfo& Bundle::info() const {
+        return this->grammar_info;
+    }
+
+    bool Bundle::has_lexer() const {
+        return this->grammar_info.flags & bundle::HAS_LEXER;
+    }
+
+    bool Bundle::has_parser() const {
+        return this->grammar_info.flags & bundle::HAS_PARSER;
+    }
+
+    std::string_view Bundle::token_name(size_t id) const {
+        return this->token_names.at(id);
+    }
+
+    std::string_view Bundle::production_name(size_t id) const {
+        return this->production_names.at(id);
+    }
+
+    std::optional<uint32_t> Bundle::find_token(std::string_view name) const {
+        auto it = std::find(this->token_names.begin(), this->token_names.end(), name);
+        if (it == this->token_names.end())
+            return std::nullopt;
+        return static_cast<uint32_t>(it - this->token_names.begin());
+    }
+
+    bool Bundle::has_section(bundle::SectionId id) const {
+        return this->find_section(id) != nullptr;
+    }
+
+    size_t Bundle::num_items(bundle::SectionId id) const {
+        const auto& entry = this->require_section(id);
+        return entry.size / entry.item_bytes;
+    }
+
+    std::span<const uint8_t> Bundle::section(bundle::SectionId id, size_t item_bytes, size_t count) const {
+        const auto& entry = this->require_section(id);
+        if (entry.item_bytes != item_bytes || entry.size != item_bytes * count) {
+            throw BundleError(fmt::format(
+                "Section '{}' has {} bytes of {}-byte items, expected {} items of {} bytes",
+                section_name(id),
+                entry.size,
+                entry.item_bytes,
+                count,
+                item_bytes
+            ));
+        }
+
+        return {this->data + entry.offset, entry.size};
+    }
+
+    std::span<const int32_t> Bundle::i32_section(bundle::SectionId id, size_t count) const {
+        // Sections are aligned, so 32-bit integers can be accessed in place.
+        static_assert(std::endian::native == std::endian::little);
+        auto bytes = this->section(id, sizeof(int32_t), count);
+        return {reinterpret_cast<const int32_t*>(bytes.data()), count};
+    }
+
+    std::vector<uint32_t> Bundle::u32_section(bundle::SectionId id, size_t item_bytes, size_t count) const {
+        if (item_bytes > sizeof(uint32_t)) {
+            throw BundleError(fmt::format("Section '{}' has items wider than 32 bits", section_name(id)));
+        }
+
+        auto bytes = this->section(id, item_bytes, count);
+        auto result = std::vector<uint32_t>(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t value = 0;
+            for (size_t j = 0; j < item_bytes; ++j)
+                value |= uint32_t{bytes[i * item_bytes + j]} << (8 * j);
+            result[i] = value;
+        }
+
+        return result;
+    }
+
+    const bundle::SectionEntry* Bundle::find_section(bundle::SectionId id) const {
+        auto it = std::find_if(
+            this->sections.begin(),
+            this->sections.end(),
+            [id](const auto& entry) { return entry.id == id; }
+        );
+        return it == this->sections.end() ? nullptr : &*it;
+    }
+
+    const bundle::SectionEntry& Bundle::require_section(bundle::SectionId id) const {
+        const auto* entry = this->find_section(id);
+        if (!entry) {
+            throw BundleError(fmt::format("Missing section '{}'", section_name(id)));
+        }
+        return *entry;
+    }
+
+    void Bundle::validate() {
+        auto header = bundle::Header();
+        std::memcpy(&header, this->data, sizeof(header));
+
+        if (std::memcmp(header.magic, bundle::MAGIC, sizeof(header.magic)) != 0) {
+            throw BundleError("Not a grammar bundle");
+        }
+
+        if (header.version_major != bundle::VERSION_MAJOR) {
+            throw BundleError(fmt::format(
+                "Unsupported version {}.{} (expected {}.x)",
+                header.version_major,
+                header.version_minor,
+                bundle::VERSION_MAJOR
+            ));
+        }
+
+        if (header.num_sections > (this->size - sizeof(header)) / sizeof(bundle::SectionEntry)) {
+            throw BundleError("Section table exceeds file size");
+        }
+
+        this->sections.resize(header.num_sections);
+        std::memcpy(
+            this->sections.data(),
+            this->data + sizeof(header),
+            header.num_sections * sizeof(bundle::SectionEntry)
+        );
+
+        for (const auto& entry : this->sections) {
+            if (entry.offset % bundle::SECTION_ALIGN != 0
+                || entry.offset > this->size
+                || entry.size > this->size - entry.offset) {
+                throw BundleError(fmt::format("Section '{}' is out of bounds or misaligned", section_name(entry.id)));
+            }
+
+            if (!std::has_single_bit(entry.item_bytes) || entry.item_bytes > sizeof(uint64_t) || entry.size % entry.item_bytes != 0) {
+                throw BundleError(fmt::format("Section '{}' has invalid item size", section_name(entry.id)));
+            }
+        }
+
+        // Later minor versions may append fields to the grammar info.
+        const auto& info = this->require_section(bundle::SectionId::GRAMMAR_INFO);
+        if (info.item_bytes != sizeof(uint32_t) || info.size < sizeof(bundle::GrammarInfo)) {
+            throw BundleError("Grammar info is too small");
+        }
+        std::memcpy(&this->grammar_info, this->data + info.offset, sizeof(bundle::GrammarInfo));
+
+        this->token_names = this->read_names(bundle::SectionId::TOKEN_NAMES, this->grammar_info.num_tokens);
+        if (this->has_parser()) {
+            this->production_names = this->read_names(bundle::SectionId::PRODUCTION_NAMES, this->grammar_info.num_productions);
+        }
+    }
+
+    std::vector<std::string_view> Bundle::read_names(bundle::SectionId id, size_t count) const {
+        const auto& entry = this->require_section(id);
+        const auto* base = this->data + entry.offset;
+
+        // The count, and count + 1 offsets.
+        size_t header_size = (count + 2) * sizeof(uint32_t);
+        if (entry.size < header_size || read_u32(base) != count) {
+            throw BundleError(fmt::format("Section '{}' does not hold {} names", section_name(id), count));
+        }
+
+        const auto* chars = reinterpret_cast<const char*>(base + header_size);
+        size_t num_chars = entry.size - header_size;
+
+        auto names = std::vector<std::string_view>();
+        names.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto begin = read_u32(base + (i + 1) * sizeof(uint32_t));
+            auto end = read_u32(base + (i + 2) * sizeof(uint32_t));
+            if (begin > end || end > num_chars) {
+                throw BundleError(fmt::format("Section '{}' has an invalid name", section_name(id)));
+            }
+            names.emplace_back(chars + begin, end - begin);
+        }
+
+        return names;
+    }
+}
@@ -0,0 +1,564 @@
+#include "generic_futhark_generated.h"
+
+#include "pareas/generic/bundle.hpp"
+#include "pareas/generic/futhark_interop.hpp"
+#include "pareas/parser/bracket_check.hpp"
+#include "pareas/profiler/profiler.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <fmt/chrono.h>
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+// This file is mostly just copied from src/json/main.cpp, but the grammar is loaded at runtime
+// from a grammar bundle instead of being compiled in.
+
+namespace bundle = pareas::bundle;
+using pareas::generic::Bundle;
+
+struct Options {
+    const char* bundle_path;
+    const char* input_path;
+    std::vector<std::string_view> skip_tokens;
+    bool help;
+    bool futhark_verbose;
+    bool futhark_debug;
+    bool futhark_debug_extra;
+    bool dump_dot;
+    bool verbose_tree;
+
+    // Options available for the multicore backend
+    int threads;
+
+    // Options abailable for the OpenCL and CUDA backends
+    const char* device_name;
+    bool futhark_profile;
+};
+
+void print_usage(char* progname) {
+    fmt::print(
+        "Usage: {} [options...] <bundle path> <input path>\n"
+        "Available options:\n"
+        "-h --help                   Show this message and exit.\n"
+        "--skip <token>              Remove tokens named <token> from the input before parsing.\n"
+        "                            May be given multiple times. (default: whitespace, comment)\n"
+        "--futhark-verbose           Enable Futhark logging.\n"
+        "--futhark-debug             Enable Futhark debug logging.\n"
+        "--futhark-debug-extra       Futhark debug logging with extra information.\n"
+        "                            Not compatible with --futhark-debug.\n"
+        "--dump-dot                  Dump parse tree as dot graph. Disables profiling.\n"
+        "--verbose-tree              Print some information about the parse tree.\n"
+    #if defined(FUTHARK_BACKEND_multicore)
+        "Available backend options:\n"
+        "-t --threads <amount>       Set the maximum number of threads that may be used\n"
+        "                            (default: amount of cores).\n"
+    #elif defined(FUTHARK_BACKEND_opencl) || defined(FUTHARK_BACKEND_cuda)
+        "Available backend options:\n"
+        "--device <name>             Select the device that kernels are executed on. Any\n"
+        "                            device which name contains <name> may be used. The\n"
+        "                            special value #k may be used to select the k-th\n"
+        "                            device reported by the platform.\n"
+        "--futhark-profile           Enable Futhark profiling and print report at exit.\n"
+    #endif
+        "\n"
+        "<bundle path> is a grammar bundle generated by pareas-lpg --bundle, which must\n"
+        "contain both a lexer and a parser. When <input path> is '-', standard input is used\n",
+        progname
+    );
+}
+
+bool parse_options(Options* opts, int argc, char* argv[]) {
+    *opts = {
+        .bundle_path = nullptr,
+        .input_path = nullptr,
+        .skip_tokens = {},
+        .help = false,
+        .futhark_verbose = false,
+        .futhark_debug = false,
+        .futhark_debug_extra = false,
+        .dump_dot = false,
+        .verbose_tree = false,
+        .threads = 0,
+        .device_name = nullptr,
+        .futhark_profile = false,
+    };
+
+    const char* threads_arg = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        auto arg = std::string_view(argv[i]);
+
+        #if defined(FUTHARK_BACKEND_multicore)
+            if (arg == "-t" || arg == "--threads") {
+                if (++i >= argc) {
+                    fmt::print(std::cerr, "Error: Expected argument <amount> to option {}\n", arg);
+                    return false;
+                }
+
+                threads_arg = argv[i];
+                continue;
+            }
+        #elif defined(FUTHARK_BACKEND_opencl) || defined(FUTHARK_BACKEND_cuda)
+            if (arg == "-d" || arg == "--device") {
+                if (++i >= argc) {
+                    fmt::print(std::cerr, "Error: Expected argument <name> to option {}\n", arg);
+                    return false;
+                }
+
+                opts->device_name = argv[i];
+                continue;
+            } else if (arg == "--futhark-profile") {
+                opts->futhark_profile = true;
+                continue;
+            }
+        #endif
+
+        if (arg == "-h" || arg == "--help") {
+            opts->help = true;
+        } else if (arg == "--skip") {
+            if (++i >= argc) {
+                fmt::print(std::cerr, "Error: Expected argument <token> to option {}\n", arg);
+                return false;
+            }
+
+            opts->skip_tokens.push_back(argv[i]);
+        } else if (arg == "--futhark-verbose") {
+            opts->futhark_verbose = true;
+        } else if (arg == "--futhark-debug") {
+            opts->futhark_debug = true;
+        } else if (arg == "--futhark-debug-extra") {
+            opts->futhark_debug_extra = true;
+        } else if (arg == "--dump-dot") {
+            opts->dump_dot = true;
+        } else if (arg == "--verbose-tree") {
+            opts->verbose_tree = true;
+        } else if (!opts->bundle_path) {
+            opts->bundle_path = argv[i];
+        } else if (!opts->input_path) {
+            opts->input_path = argv[i];
+        } else {
+            fmt::print(std::cerr, "Error: Unknown option {}\n", arg);
+            return false;
+        }
+    }
+
+    if (opts->help)
+        return true;
+
+    if (!opts->bundle_path) {
+        fmt::print(std::cerr, "Error: Missing required argument <bundle path>\n");
+        return false;
+    } else if (!opts->input_path) {
+        fmt::print(std::cerr, "Error: Missing required argument <input path>\n");
+        return false;
+    } else if (!opts->input_path[0]) {
+        fmt::print(std::cerr, "Error: <input path> may not be empty\n");
+        return false;
+    } else if (opts->futhark_debug && opts->futhark_debug_extra) {
+        fmt::print(std::cerr, "Error: --futhark-debug is incompatible with --futhark-debug-extra\n");
+        return false;
+    }
+
+    if (threads_arg) {
+        const auto* end = threads_arg + std::strlen(threads_arg);
+        auto [p, ec] = std::from_chars(threads_arg, end, opts->threads);
+        if (ec != std::errc() || p != end || opts->threads < 1) {
+            fmt::print(std::cerr, "Error: Invalid value '{}' for option --threads\n", threads_arg);
+            return false;
+        }
+    }
+
+    if (opts->skip_tokens.empty())
+        opts->skip_tokens = {"whitespace", "comment"};
+
+    return true;
+}
+
+template <typename T>
+struct Free {
+    void operator()(T* ptr) const {
+        free(static_cast<void*>(ptr));
+    }
+};
+
+template <typename T>
+using MallocPtr = std::unique_ptr<T, Free<T>>;
+
+// The lexer states in the bundle are as narrow as possible for the grammar, with the produces-token flag in the
+// highest bit. The lexer runtime is instantiated with 32-bit states, so move the flag to bit 31 and serialize
+// the states as little-endian 32-bit integers.
+std::vector<uint8_t> widen_lexer_states(const Bundle& b, bundle::SectionId id, size_t count) {
+    static_assert(std::endian::native == std::endian::little);
+
+    auto state_bits = b.info().lexer_state_bits;
+    auto states = b.u32_section(id, state_bits / 8, count);
+
+    uint32_t produces_token_mask = uint32_t{1} << (state_bits - 1);
+    for (auto& state : states) {
+        if (state & produces_token_mask)
+            state = (state & ~produces_token_mask) | (uint32_t{1} << 31);
+    }
+
+    auto bytes = std::vector<uint8_t>(count * sizeof(uint32_t));
+    std::memcpy(bytes.data(), states.data(), bytes.size());
+    return bytes;
+}
+
+futhark::UniqueLexTable upload_lex_table(futhark_context* ctx, const Bundle& b) {
+    const auto& info = b.info();
+    size_t n = info.lexer_states;
+
+    auto initial_states = widen_lexer_states(b, bundle::SectionId::LEXER_INITIAL_STATES, 256);
+    auto merge_table = widen_lexer_states(b, bundle::SectionId::LEXER_MERGE_TABLE, n * n);
+    auto final_states = b.u32_section(bundle::SectionId::LEXER_FINAL_STATES, info.token_bits / 8, n);
+
+    auto initial_states_array = futhark::UniqueArray<uint8_t, 1>(ctx, initial_states.data(), initial_states.size());
+    auto merge_table_array = futhark::UniqueArray<uint8_t, 1>(ctx, merge_table.data(), merge_table.size());
+    auto final_states_array = futhark::UniqueArray<uint32_t, 1>(ctx, final_states.data(), n);
+
+    auto lex_table = futhark::UniqueLexTable(ctx);
+
+    int err = futhark_entry_mk_lex_table(
+        ctx,
+        &lex_table,
+        initial_states_array.get(),
+        merge_table_array.get(),
+        final_states_array.get(),
+        info.lexer_identity_state
+    );
+
+    if (err)
+        throw futhark::Error(ctx);
+
+    return lex_table;
+}
+
+template <typename T, typename F>
+T upload_strtab(
+    futhark_context* ctx,
+    const Bundle& b,
+    size_t item_bits,
+    bundle::SectionId table_id,
+    bundle::SectionId offsets_id,
+    bundle::SectionId lengths_id,
+    F upload_fn
+) {
+    size_t num_tokens = b.info().num_tokens;
+
+    auto table = b.u32_section(table_id, item_bits / 8, b.num_items(table_id));
+    auto table_array = futhark::UniqueArray<uint32_t, 1>(ctx, table.data(), table.size());
+
+    // The offsets and lengths are already in the right format, so upload them directly from the mapping.
+    auto offsets = b.i32_section(offsets_id, num_tokens * num_tokens);
+    auto lengths = b.i32_section(lengths_id, num_tokens * num_tokens);
+    auto offsets_array = futhark::UniqueArray<int32_t, 2>(ctx, offsets.data(), num_tokens, num_tokens);
+    auto lengths_array = futhark::UniqueArray<int32_t, 2>(ctx, lengths.data(), num_tokens, num_tokens);
+
+    auto tab = T(ctx);
+
+    int err = upload_fn(ctx, &tab, table_array.get(), offsets_array.get(), lengths_array.get());
+    if (err != 0)
+        throw futhark::Error(ctx);
+
+    return tab;
+}
+
+// The stack change table and parse table are only used together, so upload them as
+// a single table of which the references are interleaved.
+futhark::UniqueFusedParseTable upload_fused_parse_table(futhark_context* ctx, const Bundle& b) {
+    const auto& info = b.info();
+
+    auto sct = upload_strtab<futhark::UniqueStackChangeTable>(
+        ctx,
+        b,
+        info.bracket_bits,
+        bundle::SectionId::STACK_CHANGE_TABLE,
+        bundle::SectionId::STACK_CHANGE_OFFSETS,
+        bundle::SectionId::STACK_CHANGE_LENGTHS,
+        futhark_entry_mk_stack_change_table
+    );
+
+    auto pt = upload_strtab<futhark::UniqueParseTable>(
+        ctx,
+        b,
+        info.production_bits,
+        bundle::SectionId::PARSE_TABLE,
+        bundle::SectionId::PARSE_OFFSETS,
+        bundle::SectionId::PARSE_LENGTHS,
+        futhark_entry_mk_parse_table
+    );
+
+    auto fpt = futhark::UniqueFusedParseTable(ctx);
+    int err = futhark_entry_mk_fused_parse_table(ctx, &fpt, sct, pt);
+    if (err)
+        throw futhark::Error(ctx);
+
+    return fpt;
+}
+
+futhark::UniqueArray<bool, 1> upload_skip_mask(futhark_context* ctx, const Bundle& b, const Options& opts) {
+    size_t num_tokens = b.info().num_tokens;
+    auto skip = std::make_unique<bool[]>(num_tokens);
+
+    // Tokens which don't appear in the grammar are ignored, so that the defaults work for any grammar.
+    for (auto name : opts.skip_tokens) {
+        if (auto id = b.find_token(name))
+            skip[*id] = true;
+    }
+
+    return futhark::UniqueArray<bool, 1>(ctx, skip.get(), num_tokens);
+}
+
+struct ParseTree {
+    size_t num_nodes;
+    std::unique_ptr<uint32_t[]> node_types;
+    std::unique_ptr<futhark::Index[]> parents;
+};
+
+void dump_dot(const ParseTree& t, const Bundle& b, std::ostream& os) {
+    fmt::print(os, "digraph tree {{\n");
+
+    for (size_t i = 0; i < t.num_nodes; ++i) {
+        auto prod = t.node_types[i];
+        auto parent = t.parents[i];
+        auto name = b.production_name(prod);
+
+        // Nodes which were removed while restructuring operator lists are their own parent.
+        if (parent >= 0 && static_cast<size_t>(parent) == i)
+            continue;
+
+        fmt::print(os, "node{} [label=\"{}\nindex={}\"]\n", i, name, i);
+
+        if (parent >= 0) {
+            fmt::print(os, "node{} -> node{};\n", parent, i);
+        } else {
+            fmt::print(os, "start{0} [style=invis];\nstart{0} -> node{0};\n", i);
+        }
+    }
+
+    fmt::print(os, "}}\n");
+}
+
+ParseTree parse(
+    futhark_context* ctx,
+    const Bundle& b,
+    const Options& opts,
+    const std::string& input,
+    pareas::Profiler& p,
+    std::FILE* debug_log
+) {
+    auto debug_log_region = [&](const char* name) {
+        if (debug_log)
+            fmt::print(debug_log, "<<<{}>>>\n", name);
+    };
+
+    const auto& info = b.info();
+
+    debug_log_region("upload");
+    p.begin();
+    p.begin();
+    auto lex_table = upload_lex_table(ctx, b);
+    auto fpt = upload_fused_parse_table(ctx, b);
+    auto skip = upload_skip_mask(ctx, b, opts);
+
+    auto arities = b.i32_section(bundle::SectionId::PRODUCTION_ARITIES, info.num_productions);
+    auto arity_array = futhark::UniqueArray<int32_t, 1>(ctx, arities.data(), arities.size());
+
+    // Only grammars which declare operator lists need to be restructured after parsing.
+    bool has_operator_lists = b.has_section(bundle::SectionId::OPERATOR_LIST_ROLES);
+    auto operator_list_roles = futhark::UniqueArray<int32_t, 1>(ctx);
+    auto left_assoc_lists = futhark::UniqueArray<int32_t, 1>(ctx);
+    if (has_operator_lists) {
+        auto roles = b.i32_section(bundle::SectionId::OPERATOR_LIST_ROLES, info.num_productions);
+        auto lists = b.i32_section(bundle::SectionId::LEFT_ASSOC_LISTS, info.num_productions);
+        operator_list_roles = futhark::UniqueArray<int32_t, 1>(ctx, roles.data(), roles.size());
+        left_assoc_lists = futhark::UniqueArray<int32_t, 1>(ctx, lists.data(), lists.size());
+    }
+    p.end("table");
+
+    p.begin();
+    auto input_array = futhark::UniqueArray<uint8_t, 1>(ctx, reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    p.end("input");
+    p.end("upload");
+
+    p.begin();
+
+    debug_log_region("tokenize");
+    auto tokens = futhark::UniqueArray<uint32_t, 1>(ctx);
+    p.measure("tokenize", [&]{
+        int err = futhark_entry_lex(ctx, &tokens, input_array, lex_table, skip);
+        if (err)
+            throw futhark::Error(ctx);
+    });
+    input_array.clear();
+    lex_table.clear();
+
+    if (opts.verbose_tree) {
+        fmt::print(std::cerr, "Num tokens: {}\n", tokens.shape()[0]);
+    }
+
+    debug_log_region("parse");
+    auto node_types = futhark::UniqueArray<uint32_t, 1>(ctx);
+    p.measure("parse", [&]{
+        bool valid = false;
+        int err = futhark_entry_parse(
+            ctx,
+            &valid,
+            &node_types,
+            tokens,
+            fpt,
+            info.token_soi,
+            info.token_eoi,
+            pareas::parser::auto_radix_max_bits(tokens.shape()[0])
+        );
+        if (err)
+            throw futhark::Error(ctx);
+        if (!valid)
+            throw std::runtime_error("Parse error");
+    });
+    fpt.clear();
+
+    debug_log_region("build parse tree");
+    auto parents = futhark::UniqueArray<futhark::Index, 1>(ctx);
+    p.measure("build parse tree", [&]{
+        int err = futhark_entry_build_parse_tree(ctx, &parents, node_types, arity_array);
+        if (err)
+            throw futhark::Error(ctx);
+    });
+
+    if (has_operator_lists) {
+        debug_log_region("reassociate");
+        p.measure("reassociate", [&]{
+            auto old_node_types = std::move(node_types);
+            auto old_parents = std::move(parents);
+            int err = futhark_entry_reassociate_operator_lists(
+                ctx,
+                &node_types,
+                &parents,
+                old_node_types,
+                old_parents,
+                operator_list_roles,
+                left_assoc_lists
+            );
+            if (err)
+                throw futhark::Error(ctx);
+        });
+    }
+
+    p.end("parse");
+
+    size_t num_nodes = node_types.shape()[0];
+
+    auto tree = ParseTree{
+        .num_nodes = num_nodes,
+        .node_types = std::make_unique<uint32_t[]>(num_nodes),
+        .parents = std::make_unique<futhark::Index[]>(num_nodes),
+    };
+
+    node_types.values(tree.node_types.get());
+    parents.values(tree.parents.get());
+
+    if (opts.verbose_tree) {
+        fmt::print(std::cerr, "Nodes: {}\n", num_nodes);
+    }
+
+    return tree;
+}
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!parse_options(&opts, argc, argv)) {
+        fmt::print(std::cerr, "See '{} --help' for usage\n", argv[0]);
+        return EXIT_FAILURE;
+    } else if (opts.help) {
+        print_usage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+
+    auto p = pareas::Profiler(9999);
+
+    std::string input;
+    if (std::strcmp(opts.input_path, "-") == 0) {
+        input = std::string(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        auto in = std::ifstream(opts.input_path, std::ios::binary);
+        if (!in) {
+            fmt::print(std::cerr, "Error: Failed to open input file '{}'\n", opts.input_path);
+            return EXIT_FAILURE;
+        }
+
+        input = std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    p.begin();
+    auto b = std::unique_ptr<Bundle>();
+    try {
+        b = std::make_unique<Bundle>(opts.bundle_path);
+    } catch (const pareas::generic::BundleError& err) {
+        fmt::print(std::cerr, "Error: {}\n", err.what());
+        return EXIT_FAILURE;
+    }
+
+    if (!b->has_lexer() || !b->has_parser()) {
+        fmt::print(std::cerr, "Error: Bundle '{}' does not contain both a lexer and a parser\n", opts.bundle_path);
+        return EXIT_FAILURE;
+    }
+    p.end("load bundle");
+
+    p.begin();
+    auto config = futhark::ContextConfig(futhark_context_config_new());
+
+    futhark_context_config_set_logging(config.get(), opts.futhark_verbose);
+    futhark_context_config_set_debugging(config.get(), opts.futhark_debug || opts.futhark_debug_extra);
+
+    #if defined(FUTHARK_BACKEND_multicore)
+        futhark_context_config_set_num_threads(config.get(), opts.threads);
+    #elif defined(FUTHARK_BACKEND_opencl) || defined(FUTHARK_BACKEND_cuda)
+        if (opts.device_name) {
+            futhark_context_config_set_device(config.get(), opts.device_name);
+        }
+
+        futhark_context_config_set_profiling(config.get(), opts.futhark_profile);
+    #endif
+
+    auto ctx = futhark::Context(futhark_context_new(config.get()));
+    futhark_context_set_logging_file(ctx.get(), stderr);
+    p.set_sync_callback([ctx = ctx.get()]{
+        if (futhark_context_sync(ctx))
+            throw futhark::Error(ctx);
+    });
+    p.end("context init");
+
+    try {
+        auto tree = parse(ctx.get(), *b, opts, input, p, opts.futhark_debug_extra ? stderr : nullptr);
+
+        if (opts.dump_dot)
+            dump_dot(tree, *b, std::cout);
+        else
+            p.dump(std::cout);
+
+        if (opts.futhark_profile) {
+            auto report = MallocPtr<char>(futhark_context_report(ctx.get()));
+            fmt::print(std::cerr, "Profile report:\n{}", report);
+        }
+    } catch (const futhark::Error& err) {
+        fmt::print(std::cerr, "Futhark error: {}\n", err.what());
+        return EXIT_FAILURE;
+    } catch (const std::runtime_error& err) {
+        fmt::print(std::cerr, "Error: {}\n", err.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,424 @@
+#include "pareas/host/lexer_kernel.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define PAREAS_HOST_X86 1
+    #include <immintrin.h>
+
+    // The vector kernels are compiled for their instruction set using target attributes rather than compiler
+    // flags, so that the rest of the program can still run on CPUs without them. They are only called after
+    // checking that the CPU supports them.
+    #define PAREAS_TARGET_AVX2 __attribute__((target("avx2")))
+    #define PAREAS_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+    #define PAREAS_HOST_X86 0
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace pareas::host {
+    namespace {
+        // The number of bytes of each lane in a block. This keeps the input of a block in cache between the two
+        // passes over it.
+        constexpr const size_t MAX_LANE_LENGTH = 4096;
+
+        // Inputs with fewer bytes per lane than this are scanned sequentially.
+        constexpr const size_t MIN_LANE_LENGTH = 16;
+
+        template <typename State>
+        struct Tables {
+            constexpr const static State STATE_MASK = LexerKernel<State>::STATE_MASK;
+
+            size_t n;
+            const State* initial_states;
+            const State* merge_table;
+            const State* byte_transitions;
+
+            State step(State state, uint8_t byte) const {
+                return this->byte_transitions[(size_t(state & STATE_MASK) << 8) | byte];
+            }
+
+            State merge(State first, State second) const {
+                return this->merge_table[size_t(first & STATE_MASK) * this->n + (second & STATE_MASK)];
+            }
+        };
+
+        // Scan the input, given the state before its first byte, and return the state after its last byte.
+        // `Lanes` implements the two passes over a block, where lane l of a block of lane length m consists of
+        // the bytes in [l * m, (l + 1) * m):
+        // - `compose` computes the composition of the states of the bytes of each lane.
+        // - `rescan` computes the state after each byte of each lane, given the state before each lane.
+        template <typename State, typename Lanes>
+        State scan_blocks(const Tables<State>& t, const uint8_t* input, size_t size, State* states, State prev) {
+            constexpr const size_t LANES = Lanes::LANES;
+
+            while (size >= LANES * MIN_LANE_LENGTH) {
+                // The vector kernels process 4 bytes of each lane at a time.
+                size_t m = std::min(size / LANES, MAX_LANE_LENGTH) & ~size_t{3};
+
+                auto lane_states = std::array<State, LANES>();
+                Lanes::compose(t, input, m, lane_states.data());
+
+                // Compute the state before each lane.
+                for (auto& state : lane_states) {
+                    auto composed = t.merge(prev, state);
+                    state = prev;
+                    prev = composed;
+                }
+
+                Lanes::rescan(t, input, m, lane_states.data(), states);
+
+                input += LANES * m;
+                states += LANES * m;
+                size -= LANES * m;
+            }
+
+            for (size_t i = 0; i < size; ++i)
+                states[i] = prev = t.step(prev, input[i]);
+
+            return prev;
+        }
+
+        // The lanes are independent, so interleaving them allows the CPU to overlap their table lookups. The
+        // tables are copied to a local, as otherwise the compiler has to assume that the stores of 8-bit states
+        // may alias them.
+        template <typename State>
+        struct ScalarLanes {
+            constexpr const static size_t LANES = 8;
+
+            static void compose(const Tables<State>& tables, const uint8_t* input, size_t m, State* lane_states) {
+                const auto t = tables;
+                uint32_t s[LANES];
+                for (size_t l = 0; l < LANES; ++l)
+                    s[l] = t.initial_states[input[l * m]];
+
+                for (size_t j = 1; j < m; ++j) {
+                    for (size_t l = 0; l < LANES; ++l)
+                        s[l] = t.step(s[l], input[l * m + j]);
+                }
+
+                std::copy(s, s + LANES, lane_states);
+            }
+
+            static void rescan(const Tables<State>& tables, const uint8_t* input, size_t m, const State* lane_states, State* states) {
+                const auto t = tables;
+                uint32_t s[LANES];
+                std::copy(lane_states, lane_states + LANES, s);
+
+                for (size_t j = 0; j < m; ++j) {
+                    for (size_t l = 0; l < LANES; ++l) {
+                        s[l] = t.step(s[l], input[l * m + j]);
+                        states[l * m + j] = s[l];
+                    }
+                }
+            }
+        };
+
+    #if PAREAS_HOST_X86
+        // Each lane of a vector holds a state in the lower bits of a 32-bit integer. Table entries are gathered
+        // as 32-bit integers of which the excess upper bits are ignored, which is why the byte transition table
+        // is padded.
+        template <typename State>
+        struct Avx2Lanes {
+            // Two vectors are processed at a time, so that the latency of their gathers overlaps.
+            constexpr const static size_t VECTORS = 2;
+            constexpr const static size_t WIDTH = 8;
+            constexpr const static size_t LANES = VECTORS * WIDTH;
+
+            PAREAS_TARGET_AVX2
+            static __m256i lane_offsets(size_t v, size_t m) {
+                auto lanes = _mm256_add_epi32(_mm256_set1_epi32(v * WIDTH), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+                return _mm256_mullo_epi32(lanes, _mm256_set1_epi32(m));
+            }
+
+            PAREAS_TARGET_AVX2
+            static __m256i step(const Tables<State>& t, __m256i s, __m256i bytes, int k) {
+                auto byte = _mm256_and_si256(_mm256_srli_epi32(bytes, 8 * k), _mm256_set1_epi32(0xFF));
+                auto index = _mm256_or_si256(
+                    _mm256_slli_epi32(_mm256_and_si256(s, _mm256_set1_epi32(Tables<State>::STATE_MASK)), 8),
+                    byte
+                );
+                return _mm256_i32gather_epi32(reinterpret_cast<const int*>(t.byte_transitions), index, sizeof(State));
+            }
+
+            PAREAS_TARGET_AVX2
+            static __m256i load_bytes(const uint8_t* input, __m256i offsets, size_t j) {
+                auto index = _mm256_add_epi32(offsets, _mm256_set1_epi32(j));
+                return _mm256_i32gather_epi32(reinterpret_cast<const int*>(input), index, 1);
+            }
+
+            PAREAS_TARGET_AVX2
+            static void compose(const Tables<State>& t, const uint8_t* input, size_t m, State* lane_states) {
+                __m256i offsets[VECTORS];
+                __m256i s[VECTORS];
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(32) uint32_t initial[WIDTH];
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        initial[i] = t.initial_states[input[(v * WIDTH + i) * m]];
+
+                    offsets[v] = lane_offsets(v, m);
+                    s[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(initial));
+
+                    // The first byte of each lane is used for the initial state above.
+                    auto bytes = load_bytes(input, offsets[v], 0);
+                    for (int k = 1; k < 4; ++k)
+                        s[v] = step(t, s[v], bytes, k);
+                }
+
+                for (size_t j = 4; j < m; j += 4) {
+                    __m256i bytes[VECTORS];
+                    for (size_t v = 0; v < VECTORS; ++v)
+                        bytes[v] = load_bytes(input, offsets[v], j);
+
+                    for (int k = 0; k < 4; ++k) {
+                        for (size_t v = 0; v < VECTORS; ++v)
+                            s[v] = step(t, s[v], bytes[v], k);
+                    }
+                }
+
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(32) uint32_t result[WIDTH];
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(result), s[v]);
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        lane_states[v * WIDTH + i] = result[i];
+                }
+            }
+
+            PAREAS_TARGET_AVX2
+            static void rescan(const Tables<State>& t, const uint8_t* input, size_t m, const State* lane_states, State* states) {
+                __m256i offsets[VECTORS];
+                __m256i s[VECTORS];
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(32) uint32_t initial[WIDTH];
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        initial[i] = lane_states[v * WIDTH + i];
+
+                    offsets[v] = lane_offsets(v, m);
+                    s[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(initial));
+                }
+
+                for (size_t j = 0; j < m; j += 4) {
+                    __m256i bytes[VECTORS];
+                    for (size_t v = 0; v < VECTORS; ++v)
+                        bytes[v] = load_bytes(input, offsets[v], j);
+
+                    // The vectors hold the states of different lanes, which are not contiguous in the output.
+                    // Collect the states of 4 bytes, and then write 4 contiguous states for each lane.
+                    alignas(32) uint32_t result[4][LANES];
+                    for (int k = 0; k < 4; ++k) {
+                        for (size_t v = 0; v < VECTORS; ++v) {
+                            s[v] = step(t, s[v], bytes[v], k);
+                            _mm256_store_si256(reinterpret_cast<__m256i*>(&result[k][v * WIDTH]), s[v]);
+                        }
+                    }
+
+                    for (size_t l = 0; l < LANES; ++l) {
+                        for (int k = 0; k < 4; ++k)
+                            states[l * m + j + k] = result[k][l];
+                    }
+                }
+            }
+        };
+
+        // Like `Avx2Lanes`, but with 16 states per vector.
+        template <typename State>
+        struct Avx512Lanes {
+            constexpr const static size_t VECTORS = 2;
+            constexpr const static size_t WIDTH = 16;
+            constexpr const static size_t LANES = VECTORS * WIDTH;
+
+            PAREAS_TARGET_AVX512
+            static __m512i lane_offsets(size_t v, size_t m) {
+                auto lanes = _mm512_add_epi32(
+                    _mm512_set1_epi32(v * WIDTH),
+                    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+                );
+                return _mm512_mullo_epi32(lanes, _mm512_set1_epi32(m));
+            }
+
+            // The masked variants of the intrinsics are used, as the unmasked ones trigger spurious warnings about
+            // uninitialized variables in some versions of GCC.
+            constexpr const static __mmask16 ALL = 0xFFFF;
+
+            PAREAS_TARGET_AVX512
+            static __m512i step(const Tables<State>& t, __m512i s, __m512i bytes, int k) {
+                auto byte = _mm512_and_si512(_mm512_maskz_srli_epi32(ALL, bytes, 8 * k), _mm512_set1_epi32(0xFF));
+                auto index = _mm512_or_si512(
+                    _mm512_maskz_slli_epi32(ALL, _mm512_and_si512(s, _mm512_set1_epi32(Tables<State>::STATE_MASK)), 8),
+                    byte
+                );
+                return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ALL, index, t.byte_transitions, sizeof(State));
+            }
+
+            PAREAS_TARGET_AVX512
+            static __m512i load_bytes(const uint8_t* input, __m512i offsets, size_t j) {
+                auto index = _mm512_add_epi32(offsets, _mm512_set1_epi32(j));
+                return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ALL, index, input, 1);
+            }
+
+            PAREAS_TARGET_AVX512
+            static void compose(const Tables<State>& t, const uint8_t* input, size_t m, State* lane_states) {
+                __m512i offsets[VECTORS];
+                __m512i s[VECTORS];
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(64) uint32_t initial[WIDTH];
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        initial[i] = t.initial_states[input[(v * WIDTH + i) * m]];
+
+                    offsets[v] = lane_offsets(v, m);
+                    s[v] = _mm512_load_si512(initial);
+
+                    auto bytes = load_bytes(input, offsets[v], 0);
+                    for (int k = 1; k < 4; ++k)
+                        s[v] = step(t, s[v], bytes, k);
+                }
+
+                for (size_t j = 4; j < m; j += 4) {
+                    __m512i bytes[VECTORS];
+                    for (size_t v = 0; v < VECTORS; ++v)
+                        bytes[v] = load_bytes(input, offsets[v], j);
+
+                    for (int k = 0; k < 4; ++k) {
+                        for (size_t v = 0; v < VECTORS; ++v)
+                            s[v] = step(t, s[v], bytes[v], k);
+                    }
+                }
+
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(64) uint32_t result[WIDTH];
+                    _mm512_store_si512(result, s[v]);
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        lane_states[v * WIDTH + i] = result[i];
+                }
+            }
+
+            PAREAS_TARGET_AVX512
+            static void rescan(const Tables<State>& t, const uint8_t* input, size_t m, const State* lane_states, State* states) {
+                __m512i offsets[VECTORS];
+                __m512i s[VECTORS];
+                for (size_t v = 0; v < VECTORS; ++v) {
+                    alignas(64) uint32_t initial[WIDTH];
+                    for (size_t i = 0; i < WIDTH; ++i)
+                        initial[i] = lane_states[v * WIDTH + i];
+
+                    offsets[v] = lane_offsets(v, m);
+                    s[v] = _mm512_load_si512(initial);
+                }
+
+                for (size_t j = 0; j < m; j += 4) {
+                    __m512i bytes[VECTORS];
+                    for (size_t v = 0; v < VECTORS; ++v)
+                        bytes[v] = load_bytes(input, offsets[v], j);
+
+                    alignas(64) uint32_t result[4][LANES];
+                    for (int k = 0; k < 4; ++k) {
+                        for (size_t v = 0; v < VECTORS; ++v) {
+                            s[v] = step(t, s[v], bytes[v], k);
+                            _mm512_store_si512(&result[k][v * WIDTH], s[v]);
+                        }
+                    }
+
+                    for (size_t l = 0; l < LANES; ++l) {
+                        for (int k = 0; k < 4; ++k)
+                            states[l * m + j + k] = result[k][l];
+                    }
+                }
+            }
+        };
+    #endif
+    }
+
+    const char* isa_name(Isa isa) {
+        switch (isa) {
+            case Isa::SCALAR: return "scalar";
+            case Isa::AVX2: return "avx2";
+            case Isa::AVX512: return "avx512";
+        }
+
+        return "(unknown)";
+    }
+
+    bool isa_supported(Isa isa) {
+        switch (isa) {
+            case Isa::SCALAR:
+                return true;
+        #if PAREAS_HOST_X86
+            case Isa::AVX2:
+                return __builtin_cpu_supports("avx2");
+            case Isa::AVX512:
+                return __builtin_cpu_supports("avx512f");
+        #endif
+            default:
+                return false;
+        }
+    }
+
+    Isa detect_isa() {
+        for (auto isa : {Isa::AVX512, Isa::AVX2}) {
+            if (isa_supported(isa))
+                return isa;
+        }
+
+        return Isa::SCALAR;
+    }
+
+    template <typename State>
+    LexerKernel<State>::LexerKernel(size_t n, const State* initial_states, const State* merge_table, Isa isa):
+        n(n), initial_states(initial_states), merge_table(merge_table), isa(isa) {
+        // The vector kernels index the byte transition table with 32-bit integers.
+        if (n * 256 > size_t{std::numeric_limits<int32_t>::max()})
+            this->isa = Isa::SCALAR;
+        else if (!isa_supported(isa))
+            this->isa = detect_isa();
+
+        // Pad the table such that a 32-bit integer may be read at every entry.
+        this->byte_transitions.resize(n * 256 + sizeof(uint32_t) / sizeof(State), 0);
+        for (size_t state = 0; state < n; ++state) {
+            for (size_t byte = 0; byte < 256; ++byte) {
+                auto initial = initial_states[byte] & STATE_MASK;
+                this->byte_transitions[(state << 8) | byte] = merge_table[state * n + initial];
+            }
+        }
+    }
+
+    template <typename State>
+    Isa LexerKernel<State>::instruction_set() const {
+        return this->isa;
+    }
+
+    template <typename State>
+    void LexerKernel<State>::scan(std::span<const uint8_t> input, std::span<State> states) const {
+        assert(states.size() >= input.size());
+
+        if (input.empty())
+            return;
+
+        auto t = Tables<State>{this->n, this->initial_states, this->merge_table, this->byte_transitions.data()};
+
+        // The first byte is never merged with a previous state.
+        states[0] = this->initial_states[input[0]];
+
+        const auto* rest = input.data() + 1;
+        auto* rest_states = states.data() + 1;
+        auto size = input.size() - 1;
+
+        switch (this->isa) {
+        #if PAREAS_HOST_X86
+            case Isa::AVX2:
+                scan_blocks<State, Avx2Lanes<State>>(t, rest, size, rest_states, states[0]);
+                break;
+            case Isa::AVX512:
+                scan_blocks<State, Avx512Lanes<State>>(t, rest, size, rest_states, states[0]);
+                break;
+        #endif
+            default:
+                scan_blocks<State, ScalarLanes<State>>(t, rest, size, rest_states, states[0]);
+                break;
+        }
+    }
+
+    template class LexerKernel<uint8_t>;
+    template class LexerKernel<uint16_t>;
+    template class LexerKernel<uint32_t>;
+}
@@ -2,6 +2,8 @@
 #include "json_grammar.hpp"
 
 #include "pareas/json/futhark_interop.hpp"
+#include "pareas/host/lexer_kernel.hpp"
+#include "pareas/parser/bracket_check.hpp"
 #include "pareas/profiler/profiler.hpp"
 
 #include <fmt/format.h>
@@ -13,6 +15,8 @@
 #include <iostream>
 #include <fstream>
 #include <charconv>
+#include <chrono>
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 
@@ -26,6 +30,7 @@ struct Options {
     bool futhark_debug_extra;
     bool dump_dot;
     bool verbose_tree;
+    bool bench_lexer;
 
     // Options available for the multicore backend
     int threads;
@@ -46,6 +51,8 @@ void print_usage(char* progname) {
         "                            Not compatible with --futhark-debug.\n"
         "--dump-dot                  Dump JSON tree as dot graph. Disables profiling.\n"
         "--verbose-tree              Print some information about the document tree.\n"
+        "--bench-lexer               Compare the throughput of the Futhark lexer with that\n"
+        "                            of the host lexer kernel instead of parsing.\n"
     #if defined(FUTHARK_BACKEND_multicore)
         "Available backend options:\n"
         "-t --threads <amount>       Set the maximum number of threads that may be used\n"
@@ -73,6 +80,7 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
         .futhark_debug_extra = false,
         .dump_dot = false,
         .verbose_tree = false,
+        .bench_lexer = false,
         .threads = 0,
         .device_name = nullptr,
         .futhark_profile = false,
@@ -120,6 +128,8 @@ bool parse_options(Options* opts, int argc, char* argv[]) {
             opts->dump_dot = true;
         } else if (arg == "--verbose-tree") {
             opts->verbose_tree = true;
+        } else if (arg == "--bench-lexer") {
+            opts->bench_lexer = true;
         } else if (!opts->input_path) {
             opts->input_path = argv[i];
         } else {
@@ -165,17 +175,17 @@ template <typename T>
 using MallocPtr = std::unique_ptr<T, Free<T>>;
 
 futhark::UniqueLexTable upload_lex_table(futhark_context* ctx) {
-    auto initial_state = futhark::UniqueArray<uint16_t, 1>(
+    // The width of a lexer state depends on the grammar, so the tables are uploaded as bytes.
+    auto initial_state = futhark::UniqueArray<uint8_t, 1>(
         ctx,
-        reinterpret_cast<const json::LexTable::State*>(json::lex_table.initial_states),
-        json::LexTable::NUM_INITIAL_STATES
+        reinterpret_cast<const uint8_t*>(json::lex_table.initial_states),
+        json::LexTable::NUM_INITIAL_STATES * sizeof(json::LexTable::State)
     );
 
-    auto merge_table = futhark::UniqueArray<uint16_t, 2>(
+    auto merge_table = futhark::UniqueArray<uint8_t, 1>(
         ctx,
-        reinterpret_cast<const json::LexTable::State*>(json::lex_table.merge_table),
-        json::lex_table.n,
-        json::lex_table.n
+        reinterpret_cast<const uint8_t*>(json::lex_table.merge_table),
+        json::lex_table.n * json::lex_table.n * sizeof(json::LexTable::State)
     );
 
     auto final_state = futhark::UniqueArray<uint8_t, 1>(
@@ -225,7 +235,7 @@ T upload_strtab(futhark_context* ctx, const json::StrTab<U>& strtab, F upload_fn
 struct JsonTree {
     size_t num_nodes;
     std::unique_ptr<json::Production[]> node_types;
-    std::unique_ptr<int32_t[]> parents;
+    std::unique_ptr<futhark::Index[]> parents;
 };
 
 void dump_dot(const JsonTree& j, std::ostream& os) {
@@ -298,11 +308,16 @@ JsonTree parse(futhark_context* ctx, const std::string& input, bool verbose_tree
         fmt::print(std::cerr, "Num tokens: {}\n", tokens.shape()[0]);
     }
 
+    auto radix_max_bits = pareas::parser::auto_radix_max_bits(tokens.shape()[0]);
+    if (verbose_tree) {
+        fmt::print(std::cerr, "Max bracket depth bits for radix sort check: {}\n", radix_max_bits);
+    }
+
     debug_log_region("parse");
     auto node_types = futhark::UniqueArray<uint8_t, 1>(ctx);
     p.measure("parse", [&]{
         bool valid = false;
-        int err = futhark_entry_json_parse(ctx, &valid, &node_types, tokens, sct, pt);
+        int err = futhark_entry_json_parse(ctx, &valid, &node_types, tokens, sct, pt, radix_max_bits);
         if (err)
             throw futhark::Error(ctx);
         if (!valid)
@@ -312,7 +327,7 @@ JsonTree parse(futhark_context* ctx, const std::string& input, bool verbose_tree
     pt.clear();
 
     debug_log_region("build parse tree");
-    auto parents = futhark::UniqueArray<int32_t, 1>(ctx);
+    auto parents = futhark::UniqueArray<futhark::Index, 1>(ctx);
     p.measure("build parse tree", [&]{
         int err = futhark_entry_json_build_parse_tree(ctx, &parents, node_types, arity_array);
         if (err)
@@ -349,7 +364,7 @@ JsonTree parse(futhark_context* ctx, const std::string& input, bool verbose_tree
     auto ast = JsonTree {
         .num_nodes = num_nodes,
         .node_types = std::make_unique<json::Production[]>(num_nodes),
-        .parents = std::make_unique<int32_t[]>(num_nodes),
+        .parents = std::make_unique<futhark::Index[]>(num_nodes),
     };
 
     int err = futhark_values_u8_1d(
@@ -358,11 +373,11 @@ JsonTree parse(futhark_context* ctx, const std::string& input, bool verbose_tree
         reinterpret_cast<std::underlying_type_t<json::Production>*>(ast.node_types.get())
     );
 
-    err |= futhark_values_i32_1d(ctx, parents, ast.parents.get());
-
     if (err)
         throw futhark::Error(ctx);
 
+    parents.values(ast.parents.get());
+
     if (verbose_tree) {
         fmt::print(std::cerr, "Nodes: {}\n", num_nodes);
     }
@@ -370,6 +385,61 @@ JsonTree parse(futhark_context* ctx, const std::string& input, bool verbose_tree
     return ast;
 }
 
+// Lex the input a number of times, and report the throughput of the fastest run.
+template <typename F>
+void bench_throughput(const char* name, size_t input_size, F f) {
+    constexpr const size_t RUNS = 10;
+
+    auto best = std::chrono::duration<double>::max();
+    size_t tokens = 0;
+    for (size_t i = 0; i < RUNS; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        tokens = f();
+        best = std::min<std::chrono::duration<double>>(best, std::chrono::high_resolution_clock::now() - start);
+    }
+
+    fmt::print("{:<16} {:>10.3f} GB/s ({} tokens)\n", name, input_size / best.count() / 1e9, tokens);
+}
+
+void bench_lexer(futhark_context* ctx, const std::string& input) {
+    auto lex_table = upload_lex_table(ctx);
+    auto input_array = futhark::UniqueArray<uint8_t, 1>(ctx, reinterpret_cast<const uint8_t*>(input.data()), input.size());
+
+    bench_throughput("futhark", input.size(), [&]{
+        auto tokens = futhark::UniqueArray<uint8_t, 1>(ctx);
+        int err = futhark_entry_json_lex(ctx, &tokens, input_array, lex_table);
+        if (err || (err = futhark_context_sync(ctx)))
+            throw futhark::Error(ctx);
+        return size_t(tokens.shape()[0]);
+    });
+
+    auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    auto states = std::vector<json::LexTable::State>(input.size());
+
+    for (auto isa : {pareas::host::Isa::SCALAR, pareas::host::Isa::AVX2, pareas::host::Isa::AVX512}) {
+        if (!pareas::host::isa_supported(isa))
+            continue;
+
+        auto kernel = pareas::host::LexerKernel<json::LexTable::State>(
+            json::lex_table.n,
+            json::lex_table.initial_states,
+            json::lex_table.merge_table,
+            isa
+        );
+
+        auto scan_name = fmt::format("{} scan", pareas::host::isa_name(isa));
+        bench_throughput(scan_name.c_str(), input.size(), [&]{
+            kernel.scan(bytes, states);
+            return size_t(0);
+        });
+
+        auto lex_name = fmt::format("{} lex", pareas::host::isa_name(isa));
+        bench_throughput(lex_name.c_str(), input.size(), [&]{
+            return kernel.lex(bytes, json::lex_table.final_states).size();
+        });
+    }
+}
+
 int main(int argc, char* argv[]) {
     Options opts;
     if (!parse_options(&opts, argc, argv)) {
@@ -416,6 +486,11 @@ int main(int argc, char* argv[]) {
     p.end("context init");
 
     try {
+        if (opts.bench_lexer) {
+            bench_lexer(ctx.get(), input);
+            return EXIT_SUCCESS;
+        }
+
         auto ast = parse(ctx.get(), input, opts.verbose_tree, p, opts.futhark_debug_extra ? stderr : nullptr);
 
         if (opts.dump_dot)
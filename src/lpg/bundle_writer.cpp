@@ -0,0 +1,186 @@
+#include "pareas/lpg/bundle_writer.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <fstream>
+#include <string_view>
+#include <bit>
+#include <cstring>
+#include <cassert>
+
+namespace {
+    using namespace pareas;
+
+    void append_int(std::string& data, uint64_t value, size_t bytes) {
+        // If the system is little endian, a value can be truncated simply by writing less bytes.
+        static_assert(std::endian::native == std::endian::little);
+        assert(bytes == sizeof(uint64_t) || value < (1ULL << (8ULL * bytes)));
+
+        data.append(reinterpret_cast<const char*>(&value), bytes);
+    }
+
+    template <typename T>
+    void append_struct(std::string& data, const T& value) {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    size_t align_up(size_t offset) {
+        return (offset + bundle::SECTION_ALIGN - 1) / bundle::SECTION_ALIGN * bundle::SECTION_ALIGN;
+    }
+
+    uint32_t special_token_id(const TokenMapping& tm, const Token& token) {
+        return tm.contains(token) ? tm.token_id(token) : bundle::NO_TOKEN;
+    }
+}
+
+namespace pareas {
+    BundleWriter::BundleWriter(const TokenMapping& tm):
+        info{
+            .flags = 0,
+            .num_tokens = static_cast<uint32_t>(tm.num_tokens()),
+            .token_bits = static_cast<uint32_t>(tm.backing_type_bits()),
+            .token_invalid = special_token_id(tm, Token::INVALID),
+            .token_soi = special_token_id(tm, Token::START_OF_INPUT),
+            .token_eoi = special_token_id(tm, Token::END_OF_INPUT),
+            .lexer_states = 0,
+            .lexer_state_bits = 0,
+            .lexer_identity_state = 0,
+            .num_productions = 0,
+            .production_bits = 0,
+            .bracket_bits = 0,
+        } {
+        auto tokens = tm.ordered_tokens();
+        this->add_names_section(
+            bundle::SectionId::TOKEN_NAMES,
+            tokens.size(),
+            [&](size_t i) -> std::string_view { return tokens[i]->name; }
+        );
+    }
+
+    void BundleWriter::add_lexer(const lexer::LexerTables& tables) {
+        this->info.flags |= bundle::HAS_LEXER;
+        this->info.lexer_states = tables.states;
+        this->info.lexer_state_bits = tables.state_bits;
+        this->info.lexer_identity_state = tables.identity_state;
+
+        this->add_int_section(bundle::SectionId::LEXER_INITIAL_STATES, tables.state_bits / 8, tables.initial_states);
+        this->add_int_section(bundle::SectionId::LEXER_MERGE_TABLE, tables.state_bits / 8, tables.merge_table);
+        this->add_int_section(bundle::SectionId::LEXER_FINAL_STATES, tables.token_bits / 8, tables.final_states);
+    }
+
+    void BundleWriter::add_parser(const parser::Grammar& g, const parser::llp::ParserTables& tables) {
+        this->info.flags |= bundle::HAS_PARSER;
+        this->info.num_productions = tables.num_productions;
+        this->info.production_bits = tables.production_bits;
+        this->info.bracket_bits = tables.bracket_bits;
+
+        this->add_names_section(
+            bundle::SectionId::PRODUCTION_NAMES,
+            g.productions.size(),
+            [&](size_t i) -> std::string_view { return g.productions[i].tag; }
+        );
+
+        this->add_int_section(bundle::SectionId::PRODUCTION_ARITIES, sizeof(int32_t), tables.arities);
+
+        if (!g.operator_lists.empty()) {
+            this->add_int_section(bundle::SectionId::OPERATOR_LIST_ROLES, sizeof(int32_t), tables.operator_list_roles);
+            this->add_int_section(bundle::SectionId::LEFT_ASSOC_LISTS, sizeof(int32_t), tables.left_assoc_lists);
+        }
+
+        const auto& sct = tables.stack_change_table;
+        this->add_int_section(bundle::SectionId::STACK_CHANGE_TABLE, sct.item_bytes, sct.superstring);
+        this->add_int_section(bundle::SectionId::STACK_CHANGE_OFFSETS, sizeof(int32_t), sct.offsets);
+        this->add_int_section(bundle::SectionId::STACK_CHANGE_LENGTHS, sizeof(int32_t), sct.lengths);
+
+        const auto& pt = tables.parse_table;
+        this->add_int_section(bundle::SectionId::PARSE_TABLE, pt.item_bytes, pt.superstring);
+        this->add_int_section(bundle::SectionId::PARSE_OFFSETS, sizeof(int32_t), pt.offsets);
+        this->add_int_section(bundle::SectionId::PARSE_LENGTHS, sizeof(int32_t), pt.lengths);
+    }
+
+    void BundleWriter::write(const std::filesystem::path& path) const {
+        auto out = std::ofstream(path, std::ios::binary);
+        if (!out) {
+            throw RenderError(fmt::format("Failed to open output file '{}'", path));
+        }
+
+        // The grammar info is only complete once all the tables have been added, so it is
+        // serialized here, as the first section.
+        auto info_section = Section{bundle::SectionId::GRAMMAR_INFO, sizeof(uint32_t), {}};
+        append_struct(info_section.data, this->info);
+
+        auto all_sections = std::vector<const Section*>{&info_section};
+        for (const auto& section : this->sections)
+            all_sections.push_back(&section);
+
+        auto header = bundle::Header{
+            .magic = {},
+            .version_major = bundle::VERSION_MAJOR,
+            .version_minor = bundle::VERSION_MINOR,
+            .num_sections = static_cast<uint32_t>(all_sections.size()),
+        };
+        std::memcpy(header.magic, bundle::MAGIC, sizeof(header.magic));
+
+        auto head = std::string();
+        append_struct(head, header);
+
+        size_t offset = align_up(sizeof(bundle::Header) + all_sections.size() * sizeof(bundle::SectionEntry));
+        for (const auto* section : all_sections) {
+            auto entry = bundle::SectionEntry{
+                .id = section->id,
+                .item_bytes = section->item_bytes,
+                .offset = offset,
+                .size = section->data.size(),
+            };
+            append_struct(head, entry);
+            offset = align_up(offset + section->data.size());
+        }
+
+        out << head;
+        size_t written = head.size();
+        for (const auto* section : all_sections) {
+            for (auto aligned = align_up(written); written < aligned; ++written)
+                out.put(0);
+
+            out << section->data;
+            written += section->data.size();
+        }
+
+        if (!out) {
+            throw RenderError(fmt::format("Failed to write output file '{}'", path));
+        }
+    }
+
+    auto BundleWriter::add_section(bundle::SectionId id, size_t item_bytes) -> Section& {
+        return this->sections.emplace_back(Section{id, static_cast<uint32_t>(item_bytes), {}});
+    }
+
+    template <typename T>
+    void BundleWriter::add_int_section(bundle::SectionId id, size_t item_bytes, const std::vector<T>& values) {
+        auto& section = this->add_section(id, item_bytes);
+        section.data.reserve(values.size() * item_bytes);
+        for (auto value : values) {
+            // Signed values are written in two's complement.
+            append_int(section.data, static_cast<uint64_t>(value) & (~0ULL >> (64 - 8 * item_bytes)), item_bytes);
+        }
+    }
+
+    template <typename F>
+    void BundleWriter::add_names_section(bundle::SectionId id, size_t n, F get_name) {
+        // Name sections are a mix of integers and characters, so they are marked as consisting of bytes.
+        auto& section = this->add_section(id, 1);
+        append_int(section.data, n, sizeof(uint32_t));
+
+        uint32_t offset = 0;
+        append_int(section.data, offset, sizeof(uint32_t));
+        for (size_t i = 0; i < n; ++i) {
+            offset += get_name(i).size();
+            append_int(section.data, offset, sizeof(uint32_t));
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            section.data.append(get_name(i));
+        }
+    }
+}
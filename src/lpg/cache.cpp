@@ -0,0 +1,178 @@
+#include "pareas/lpg/cache.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <bit>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace {
+    using namespace pareas;
+
+    constexpr const char MAGIC[8] = {'P', 'L', 'P', 'G', 'C', 'A', 'C', 'H'};
+
+    // 64-bit FNV-1a, which is stable between runs and platforms, unlike std::hash.
+    uint64_t fnv1a(uint64_t hash, std::string_view data) {
+        for (unsigned char c : data) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    std::string entry_header(std::string_view source) {
+        auto w = CacheWriter();
+        for (char c : MAGIC)
+            w.write_u8(c);
+        w.write_u32(GENERATOR_VERSION);
+        w.write_string(source);
+        return w.data();
+    }
+}
+
+namespace pareas {
+    void CacheWriter::write_u8(uint8_t value) {
+        this->buffer.push_back(static_cast<char>(value));
+    }
+
+    void CacheWriter::write_u32(uint32_t value) {
+        static_assert(std::endian::native == std::endian::little);
+        this->buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void CacheWriter::write_u64(uint64_t value) {
+        static_assert(std::endian::native == std::endian::little);
+        this->buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void CacheWriter::write_string(std::string_view value) {
+        this->write_u64(value.size());
+        this->buffer.append(value);
+    }
+
+    const std::string& CacheWriter::data() const {
+        return this->buffer;
+    }
+
+    CacheReader::CacheReader(std::string_view buffer):
+        buffer(buffer), offset(0) {}
+
+    uint8_t CacheReader::read_u8() {
+        return static_cast<uint8_t>(*this->consume(sizeof(uint8_t)));
+    }
+
+    uint32_t CacheReader::read_u32() {
+        uint32_t value;
+        std::memcpy(&value, this->consume(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    uint64_t CacheReader::read_u64() {
+        uint64_t value;
+        std::memcpy(&value, this->consume(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    std::string_view CacheReader::read_string() {
+        auto size = this->read_u64();
+        if (size > this->buffer.size() - this->offset)
+            throw CacheError("Unexpected end of cache entry");
+        return {this->consume(size), size};
+    }
+
+    size_t CacheReader::read_index(size_t bound) {
+        auto index = this->read_u32();
+        if (index >= bound)
+            throw CacheError("Cache entry refers to an invalid index");
+        return index;
+    }
+
+    size_t CacheReader::remaining() const {
+        return this->buffer.size() - this->offset;
+    }
+
+    void CacheReader::finish() const {
+        if (this->offset != this->buffer.size())
+            throw CacheError("Trailing data in cache entry");
+    }
+
+    const char* CacheReader::consume(size_t bytes) {
+        if (bytes > this->buffer.size() - this->offset)
+            throw CacheError("Unexpected end of cache entry");
+        const auto* ptr = this->buffer.data() + this->offset;
+        this->offset += bytes;
+        return ptr;
+    }
+
+    GenerationCache::GenerationCache(const std::filesystem::path& dir):
+        dir(dir) {
+        auto ec = std::error_code();
+        std::filesystem::create_directories(this->dir, ec);
+        if (ec) {
+            throw CacheError(fmt::format("Failed to create cache directory '{}': {}", this->dir, ec.message()));
+        }
+    }
+
+    std::optional<std::string> GenerationCache::load(std::string_view kind, std::string_view source) const {
+        auto in = std::ifstream(this->entry_path(kind, source), std::ios::binary);
+        if (!in)
+            return std::nullopt;
+
+        in.seekg(0, std::ios::end);
+        auto size = static_cast<size_t>(in.tellg());
+        in.seekg(0, std::ios::beg);
+
+        // Entries of older versions, or which were generated from a different source with the same hash,
+        // are simply regenerated and overwritten.
+        auto expected_header = entry_header(source);
+        if (size < expected_header.size())
+            return std::nullopt;
+
+        auto header = std::string(expected_header.size(), '\0');
+        in.read(header.data(), header.size());
+        if (!in || header != expected_header)
+            return std::nullopt;
+
+        auto data = std::string(size - header.size(), '\0');
+        in.read(data.data(), data.size());
+        if (!in)
+            return std::nullopt;
+
+        return data;
+    }
+
+    void GenerationCache::store(std::string_view kind, std::string_view source, const std::string& data) const {
+        auto path = this->entry_path(kind, source);
+
+        // Write to a temporary file first, so that concurrent or interrupted runs never observe a partial entry.
+        auto tmp_path = path;
+        tmp_path += fmt::format(".{}.tmp", getpid());
+
+        {
+            auto out = std::ofstream(tmp_path, std::ios::binary);
+            out << entry_header(source) << data;
+            if (!out) {
+                fmt::print(std::cerr, "Warning: Failed to write cache entry '{}'\n", tmp_path);
+                return;
+            }
+        }
+
+        auto ec = std::error_code();
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) {
+            fmt::print(std::cerr, "Warning: Failed to write cache entry '{}': {}\n", path, ec.message());
+        }
+    }
+
+    std::filesystem::path GenerationCache::entry_path(std::string_view kind, std::string_view source) const {
+        auto hash = fnv1a(0xcbf29ce484222325ULL, kind);
+        hash = fnv1a(hash, fmt::format("/{}/", GENERATOR_VERSION));
+        hash = fnv1a(hash, source);
+        return this->dir / fmt::format("{}-{:016x}.cache", kind, hash);
+    }
+}
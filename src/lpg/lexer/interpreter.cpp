@@ -1,36 +1,121 @@
 #include "pareas/lpg/lexer/interpreter.hpp"
+#include "pareas/lpg/parallel_util.hpp"
 
-#include <fmt/format.h>
+#include <fmt/ostream.h>
 
-#include <vector>
+#include <algorithm>
+#include <cassert>
 
 namespace pareas::lexer {
-    LexerInterpreter::LexerInterpreter(const ParallelLexer* lexer):
-        lexer(lexer) {}
-
-    void LexerInterpreter::lex_linear(std::string_view input) const {
-        auto states = std::vector<ParallelLexer::StateIndex>();
-
-        for (auto c : input) {
-            auto state = this->lexer->initial_states[c];
-            states.push_back(state.result_state);
-            if (state.produces_lexeme) {
-                auto t = this->lexer->final_states[ParallelLexer::START];
-                fmt::print("{}\n", t ? t->name : "(internal error)");
-            }
+    LexerInterpreter::LexerInterpreter(const ParallelLexer* lexer, size_t threads):
+        lexer(lexer), threads(threads), num_states(lexer->merge_table.states()) {
+        assert(this->num_states <= PRODUCES_LEXEME);
+
+        auto pack = [](const ParallelLexer::Transition& t) {
+            return static_cast<PackedTransition>(t.result_state) | (t.produces_lexeme ? PRODUCES_LEXEME : 0);
+        };
+
+        for (size_t c = 0; c < this->initial_states.size(); ++c)
+            this->initial_states[c] = pack(lexer->initial_states[c]);
+
+        this->merge_table.resize(this->num_states * this->num_states);
+        parallel_for(threads, this->num_states, [&](size_t second) {
+            for (size_t first = 0; first < this->num_states; ++first)
+                this->merge_table[first + second * this->num_states] = pack(lexer->merge_table(first, second));
+        });
+    }
+
+    auto LexerInterpreter::lex(std::string_view input) const -> std::vector<Token> {
+        if (input.empty())
+            return {};
+
+        auto chunking = Chunking(this->threads, input.size(), MIN_CHUNK_SIZE);
+
+        // First, compose the states of each chunk. The state of the last chunk is not required for the remainder.
+        auto chunk_states = std::vector<PackedTransition>(chunking.chunks);
+        parallel_for(this->threads, chunking.chunks - 1, [&](size_t i) {
+            PackedTransition state = this->lexer->identity_state_index;
+            for (size_t j = chunking.begin(i); j < chunking.end(i); ++j)
+                state = this->merge(state, this->initial(input[j]));
+            chunk_states[i] = state;
+        });
+
+        // Compute the state before the first character of each chunk. This is an exclusive scan, and so
+        // chunk_states[i] now holds the state of the last character of chunk i - 1.
+        PackedTransition prev = this->lexer->identity_state_index;
+        for (auto& state : chunk_states) {
+            auto composed = this->merge(prev, state);
+            state = prev;
+            prev = composed;
         }
 
-        for (size_t i = 1; i < input.size(); ++i) {
-            auto prev = states[i - 1];
-            auto state = this->lexer->merge_table(states[i - 1], states[i]);
-            states[i] = state.result_state;
-            if (state.produces_lexeme) {
-                auto t = this->lexer->final_states[prev];
-                fmt::print("{}\n", t ? t->name : "(internal error)");
+        // Lex each chunk independently. A token ends at a character if the transition to the next character
+        // produces a token, or if it is the last character of the input. The token is then given by the state of
+        // the character at which it ends. The start of the first token of a chunk depends on the previous chunks,
+        // so it is first recorded as starting at 0.
+        auto chunk_tokens = std::vector<std::vector<Token>>(chunking.chunks);
+        parallel_for(this->threads, chunking.chunks, [&](size_t i) {
+            auto begin = chunking.begin(i);
+            auto end = chunking.end(i);
+            auto& tokens = chunk_tokens[i];
+
+            // Note that the first character of the input is never merged with a previous state.
+            auto state = i == 0 ? this->initial(input[0]) : this->merge(chunk_states[i], this->initial(input[begin]));
+            size_t start = 0;
+
+            for (size_t j = begin; j < end; ++j) {
+                auto next = j + 1 < input.size() ? this->merge(state, this->initial(input[j + 1])) : PRODUCES_LEXEME;
+
+                if (next & PRODUCES_LEXEME) {
+                    tokens.push_back({this->lexer->final_states[state & ~PRODUCES_LEXEME], start, j + 1 - start});
+                    start = j + 1;
+                }
+
+                state = next;
             }
+        });
+
+        // Fix up the first token of each chunk: it starts where the last token of a previous chunk ends.
+        size_t start = 0;
+        size_t num_tokens = 0;
+        for (auto& tokens : chunk_tokens) {
+            if (tokens.empty())
+                continue;
+
+            tokens.front().offset = start;
+            tokens.front().size -= start;
+            start = tokens.back().offset + tokens.back().size;
+            num_tokens += tokens.size();
+        }
+
+        if (chunking.chunks == 1)
+            return std::move(chunk_tokens.front());
+
+        auto offsets = std::vector<size_t>(chunking.chunks, 0);
+        for (size_t i = 1; i < chunking.chunks; ++i)
+            offsets[i] = offsets[i - 1] + chunk_tokens[i - 1].size();
+
+        auto result = std::vector<Token>(num_tokens);
+        parallel_for(this->threads, chunking.chunks, [&](size_t i) {
+            std::copy(chunk_tokens[i].begin(), chunk_tokens[i].end(), result.begin() + offsets[i]);
+        });
+
+        return result;
+    }
+
+    void LexerInterpreter::dump_tokens(std::ostream& out, std::string_view input) const {
+        for (const auto& token : this->lex(input)) {
+            fmt::print(out, "{} {} {}\n", token.lexeme ? token.lexeme->name : "(input error)", token.offset, token.size);
         }
+    }
+
+    auto LexerInterpreter::initial(char c) const -> PackedTransition {
+        return this->initial_states[static_cast<unsigned char>(c)];
+    }
 
-        auto t = this->lexer->final_states[states.back()];
-        fmt::print("{}\n", t ? t->name : "(input error)");
+    auto LexerInterpreter::merge(PackedTransition first, PackedTransition second) const -> PackedTransition {
+        first &= ~PRODUCES_LEXEME;
+        second &= ~PRODUCES_LEXEME;
+        return this->merge_table[first + second * this->num_states];
     }
 }
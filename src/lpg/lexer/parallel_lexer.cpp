@@ -190,6 +190,66 @@ namespace pareas::lexer {
         }
     }
 
+    void ParallelLexer::save(CacheWriter& w, const LexicalGrammar& g) const {
+        // Transitions are stored as the result state, of which the highest bit marks whether a lexeme is produced.
+        auto write_transition = [&](const Transition& t) {
+            assert(t.result_state < (StateIndex{1} << 31));
+            w.write_u32(t.result_state | (t.produces_lexeme ? uint32_t{1} << 31 : 0));
+        };
+
+        w.write_u32(this->merge_table.states());
+        w.write_u32(this->identity_state_index);
+
+        w.write_u32(this->initial_states.size());
+        for (const auto& t : this->initial_states)
+            write_transition(t);
+
+        for (StateIndex i = 0; i < this->merge_table.states(); ++i) {
+            for (StateIndex j = 0; j < this->merge_table.states(); ++j)
+                write_transition(this->merge_table(i, j));
+        }
+
+        // Final states without a lexeme are stored as the number of lexemes.
+        for (const auto* lexeme : this->final_states)
+            w.write_u32(lexeme ? g.lexeme_id(lexeme) : g.lexemes.size());
+    }
+
+    ParallelLexer ParallelLexer::load(CacheReader& r, const LexicalGrammar& g) {
+        auto lexer = ParallelLexer();
+
+        size_t states = r.read_u32();
+        // Make sure that the merge table is actually stored before allocating it.
+        if (states == 0 || states > r.remaining() / states / sizeof(uint32_t))
+            throw CacheError("Unexpected end of cache entry");
+        lexer.identity_state_index = r.read_index(states);
+
+        auto read_transition = [&] {
+            auto value = r.read_u32();
+            auto result_state = value & ~(uint32_t{1} << 31);
+            if (result_state >= states)
+                throw CacheError("Cache entry refers to an invalid index");
+            return Transition(result_state, value >> 31);
+        };
+
+        lexer.initial_states.resize(r.read_u32());
+        for (auto& t : lexer.initial_states)
+            t = read_transition();
+
+        lexer.merge_table.resize(states);
+        for (StateIndex i = 0; i < states; ++i) {
+            for (StateIndex j = 0; j < states; ++j)
+                lexer.merge_table(i, j) = read_transition();
+        }
+
+        lexer.final_states.resize(states);
+        for (auto& lexeme : lexer.final_states) {
+            auto id = r.read_index(g.lexemes.size() + 1);
+            lexeme = id == g.lexemes.size() ? nullptr : &g.lexemes[id];
+        }
+
+        return lexer;
+    }
+
     void ParallelLexer::dump_sizes(std::ostream& out) const {
         fmt::print(out, "Initial states table: {} element\n", this->initial_states.size());
         fmt::print(out, "Merge table: {}² elements = {} elements\n", this->merge_table.states(), this->merge_table.states() * this->merge_table.states());
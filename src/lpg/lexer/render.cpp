@@ -1,34 +1,76 @@
 #include "pareas/lpg/lexer/render.hpp"
+#include "pareas/lpg/render_util.hpp"
 
 #include <fmt/ostream.h>
 
 #include <cassert>
 
 namespace pareas::lexer {
+    LexerTables::LexerTables(const TokenMapping& tm, const ParallelLexer& lexer):
+        states(lexer.merge_table.states()),
+        token_bits(tm.backing_type_bits()),
+        identity_state(lexer.identity_state_index) {
+        assert(this->states == lexer.final_states.size());
+
+        // Reserve one bit for the produces-token mask.
+        this->state_bits = pareas::int_bit_width(2 * (this->states - 1) + 1);
+
+        if (this->state_bits > 32) {
+            throw RenderError(fmt::format("Lexer has too many states ({})", this->states));
+        }
+
+        this->initial_states.reserve(lexer.initial_states.size());
+        for (const auto& transition : lexer.initial_states) {
+            this->initial_states.push_back(this->encode(transition));
+        }
+
+        this->merge_table.reserve(this->states * this->states);
+        // Make sure to iterate in right order
+        for (uint64_t x = 0; x < this->states; ++x) {
+            for (uint64_t y = 0; y < this->states; ++y) {
+                this->merge_table.push_back(this->encode(lexer.merge_table(x, y)));
+            }
+        }
+
+        this->final_states.reserve(this->states);
+        for (const auto* lexeme : lexer.final_states) {
+            this->final_states.push_back(lexeme ? tm.token_id(lexeme->as_token()) : tm.token_id(Token::INVALID));
+        }
+    }
+
+    auto LexerTables::encode(const ParallelLexer::Transition& t) const -> EncodedTransition {
+        assert(t.result_state < this->produces_token_mask());
+        return t.result_state | (t.produces_lexeme ? this->produces_token_mask() : 0);
+    }
+
+    auto LexerTables::produces_token_mask() const -> EncodedTransition {
+        return EncodedTransition{1} << (this->state_bits - 1);
+    }
+
     LexerRenderer::LexerRenderer(Renderer* r, const TokenMapping* tm, const ParallelLexer* lexer):
-        r(r), tm(tm), lexer(lexer) {
+        r(r), tables(*tm, *lexer) {
     }
 
     void LexerRenderer::render() const {
-        assert(this->lexer->merge_table.states() == this->lexer->final_states.size());
-
-        fmt::print(this->r->fut, "let identity_state: u{} = {}\n", ENCODED_TRANSITION_BITS, this->lexer->identity_state_index);
+        fmt::print(this->r->fut, "module lexer_state = u{}\n", this->tables.state_bits);
+        fmt::print(this->r->fut, "let identity_state: lexer_state.t = {}\n", this->tables.identity_state);
 
         fmt::print(
             this->r->hpp,
             "struct LexTable {{\n"
-            "    using State = uint16_t;\n"
+            "    using State = uint{}_t;\n"
             "    static constexpr const size_t NUM_INITIAL_STATES = 256;\n"
             "    size_t n;\n"
             "    const State* initial_states; // NUM_INITIAL_STATES\n"
             "    const State* merge_table; // n * n\n"
             "    const Token* final_states; // n\n"
             "}};\n"
-            "extern const LexTable lex_table;\n"
+            "extern const LexTable lex_table;\n",
+            this->tables.state_bits
         );
 
-        auto initial_state_offset = this->render_initial_state_data();
-        auto merge_table_offset = this->render_merge_table_data();
+        auto initial_state_offset = this->render_states(this->tables.initial_states);
+        auto merge_table_offset = this->render_states(this->tables.merge_table);
         auto final_state_offset = this->render_final_state_data();
 
         fmt::print(
@@ -39,62 +81,32 @@ namespace pareas::lexer {
             "    .merge_table = {},\n"
             "    .final_states = {}\n"
             "}};\n",
-            this->lexer->merge_table.states(),
+            this->tables.states,
             this->r->render_offset_cast(initial_state_offset, "LexTable::State"),
             this->r->render_offset_cast(merge_table_offset, "LexTable::State"),
             this->r->render_offset_cast(final_state_offset, "Token")
         );
     }
 
-    size_t LexerRenderer::render_initial_state_data() const {
-        this->r->align_data(sizeof(EncodedTransition));
+    size_t LexerRenderer::render_states(const std::vector<LexerTables::EncodedTransition>& states) const {
+        this->r->align_data(this->tables.state_bits / 8);
         auto offset = this->r->data_offset();
 
-        uint64_t dim = this->lexer->initial_states.size();
-        for (uint64_t i = 0; i < dim; ++i) {
-            const auto& transition = this->lexer->initial_states[i];
-            auto encoded = this->encode(transition);
-            this->r->write_data_int(encoded, sizeof(EncodedTransition));
-        }
-
-        return offset;
-    }
-
-    size_t LexerRenderer::render_merge_table_data() const {
-        this->r->align_data(sizeof(EncodedTransition));
-        auto offset = this->r->data_offset();
-
-        const auto& merge_table = this->lexer->merge_table;
-
-        uint64_t dim = merge_table.states();
-        // Make sure to iterate in right order
-        for (uint64_t x = 0; x < dim; ++x) {
-            for (uint64_t y = 0; y < dim; ++y) {
-                auto encoded = this->encode(merge_table(x, y));
-                this->r->write_data_int(encoded, sizeof(EncodedTransition));
-            }
+        for (auto encoded : states) {
+            this->r->write_data_int(encoded, this->tables.state_bits / 8);
         }
 
         return offset;
     }
 
     size_t LexerRenderer::render_final_state_data() const {
-        this->r->align_data(this->tm->backing_type_bits() / 8);
+        this->r->align_data(this->tables.token_bits / 8);
         auto offset = this->r->data_offset();
 
-        uint64_t dim = this->lexer->final_states.size();
-        for (uint64_t i = 0; i < dim; ++i) {
-            const auto* lexeme = this->lexer->final_states[i];
-
-            uint64_t token_definition = lexeme ? this->tm->token_id(lexeme->as_token()) : this->tm->token_id(Token::INVALID);
-            this->r->write_data_int(token_definition, this->tm->backing_type_bits() / 8);
+        for (auto token : this->tables.final_states) {
+            this->r->write_data_int(token, this->tables.token_bits / 8);
         }
 
         return offset;
     }
-
-    auto LexerRenderer::encode(const ParallelLexer::Transition& t) const -> EncodedTransition {
-        assert(t.result_state < PRODUCES_TOKEN_MASK);
-        return t.result_state | (t.produces_lexeme ? PRODUCES_TOKEN_MASK : 0);
-    }
 }
@@ -1,28 +1,38 @@
 #include "pareas/lpg/error_reporter.hpp"
 #include "pareas/lpg/parser.hpp"
 #include "pareas/lpg/cli_util.hpp"
+#include "pareas/lpg/parallel_util.hpp"
 #include "pareas/lpg/token_mapping.hpp"
 #include "pareas/lpg/renderer.hpp"
+#include "pareas/lpg/bundle_writer.hpp"
+#include "pareas/lpg/cache.hpp"
 #include "pareas/lpg/parser/grammar.hpp"
 #include "pareas/lpg/parser/grammar_parser.hpp"
 #include "pareas/lpg/parser/terminal_set_functions.hpp"
 #include "pareas/lpg/parser/ll/generator.hpp"
 #include "pareas/lpg/parser/llp/generator.hpp"
 #include "pareas/lpg/parser/llp/render.hpp"
+#include "pareas/lpg/parser/llp/interpreter.hpp"
 #include "pareas/lpg/lexer/lexer_parser.hpp"
 #include "pareas/lpg/lexer/parallel_lexer.hpp"
 #include "pareas/lpg/lexer/render.hpp"
+#include "pareas/lpg/lexer/interpreter.hpp"
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string_view>
 #include <string>
 #include <iterator>
 #include <stdexcept>
 #include <optional>
+#include <unordered_map>
+#include <chrono>
+#include <charconv>
+#include <cstring>
 #include <cstdlib>
 #include <cassert>
 
@@ -34,6 +44,10 @@ namespace {
         const char* lexer_src;
         const char* output;
         const char* namesp;
+        const char* bundle;
+        const char* cache_dir;
+        const char* test_input;
+        size_t threads;
         bool check;
         bool verbose_lexer;
         bool verbose_grammar;
@@ -53,7 +67,19 @@ namespace {
             "--lexer <lexer.lex>         Generate a lexer from <lexer.lex>.\n"
             "-o --output <path>          Basename of generated output files.\n"
             "--namespace <namespace>     Emit c++ definitions under <namespace>\n"
+            "--bundle <path>             Write the tables to a grammar bundle at <path>, which\n"
+            "                            can be loaded at runtime.\n"
             "--check                     Don't write output.\n"
+            "--cache <directory>         Cache generated lexers and parsers in <directory>, so that\n"
+            "                            they are only regenerated when their source changes.\n"
+            "--test-input <path>         Lex and/or parse <path> on the CPU using the generated\n"
+            "                            lexer and parser, and report the time it took. Tokens\n"
+            "                            which do not appear in the parser grammar are ignored.\n"
+            "                            Without --lexer, the input should consist of whitespace-\n"
+            "                            separated token names.\n"
+            "-t --threads <amount>       Maximum number of threads to use for parser generation\n"
+            "                            and for --test-input.\n"
+            "                            Defaults to the number of hardware threads.\n"
             "--verbose-lexer             Dump sizes of lexer tables.\n"
             "--verbose-grammar           Dump parsed grammar to stderr.\n"
             "--verbose-sets              Dump first/last/follow/before sets to stderr.\n"
@@ -63,7 +89,7 @@ namespace {
             "-h --help                   Show this message and exit.\n"
             "\n"
             "Either or both of --parser and --lexer are required, as well as\n"
-            "either --output and --namespace, or --check.\n",
+            "either or both of --output (with --namespace) and --bundle, or --check.\n",
             progname
         );
     }
@@ -74,6 +100,10 @@ namespace {
             .lexer_src = nullptr,
             .output = nullptr,
             .namesp = nullptr,
+            .bundle = nullptr,
+            .cache_dir = nullptr,
+            .test_input = nullptr,
+            .threads = 0,
             .check = false,
             .verbose_lexer = false,
             .verbose_grammar = false,
@@ -84,6 +114,8 @@ namespace {
             .help = false,
         };
 
+        const char* threads_arg = nullptr;
+
         for (int i = 1; i < argc; ++i) {
             auto arg = std::string_view(argv[i]);
 
@@ -102,6 +134,18 @@ namespace {
             } else if (arg == "--namespace") {
                 ptr = &opts.namesp;
                 argname = "namespace";
+            } else if (arg == "--bundle") {
+                ptr = &opts.bundle;
+                argname = "path";
+            } else if (arg == "--cache") {
+                ptr = &opts.cache_dir;
+                argname = "directory";
+            } else if (arg == "--test-input") {
+                ptr = &opts.test_input;
+                argname = "path";
+            } else if (arg == "-t" || arg == "--threads") {
+                ptr = &threads_arg;
+                argname = "amount";
             } else if (arg == "--check") {
                 opts.check = true;
             } else if (arg == "--verbose-lexer") {
@@ -136,17 +180,26 @@ namespace {
         if (opts.help)
             return true;
 
+        if (threads_arg) {
+            const auto* end = threads_arg + std::strlen(threads_arg);
+            auto [p, ec] = std::from_chars(threads_arg, end, opts.threads);
+            if (ec != std::errc() || p != end || opts.threads < 1) {
+                fmt::print(std::cerr, "Error: Invalid value '{}' for option --threads\n", threads_arg);
+                return false;
+            }
+        }
+
         if (!opts.parser_src && !opts.lexer_src) {
             fmt::print(std::cerr, "Error: Missing either or both of --parser or --lexer\n");
             return false;
         }
 
-        if (opts.check == (opts.output != nullptr)) {
-            fmt::print(std::cerr, "Error: Missing required argument --output or --check (but not both)\n");
+        if (opts.check == (opts.output != nullptr || opts.bundle != nullptr)) {
+            fmt::print(std::cerr, "Error: Missing required argument --output, --bundle or --check (but not --check with others)\n");
             return false;
         }
 
-        if (!opts.check && !opts.namesp) {
+        if (opts.output && !opts.namesp) {
             fmt::print(std::cerr, "Error: Missing required argument --namespace\n");
             return false;
         }
@@ -164,12 +217,44 @@ namespace {
         return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
     }
 
+    // Load an intermediate result from the cache, or generate it and store it in the cache if there is no valid
+    // entry for `source`. If `cache` is null, the result is always generated.
+    template <typename T, typename Generate, typename Load, typename Save>
+    T load_or_generate(
+        const GenerationCache* cache,
+        std::string_view kind,
+        std::string_view source,
+        Generate generate,
+        Load load,
+        Save save
+    ) {
+        if (!cache)
+            return generate();
+
+        if (auto data = cache->load(kind, source)) {
+            try {
+                auto r = CacheReader(data.value());
+                T result = load(r);
+                r.finish();
+                return result;
+            } catch (const CacheError& e) {
+                fmt::print(std::cerr, "Warning: Ignoring invalid {} cache entry: {}\n", kind, e.what());
+            }
+        }
+
+        T result = generate();
+        auto w = CacheWriter();
+        save(w, result);
+        cache->store(kind, source, w.data());
+        return result;
+    }
+
     struct LexerGeneration {
         lexer::LexicalGrammar grammar;
         lexer::ParallelLexer parallel_lexer;
     };
 
-    std::optional<LexerGeneration> generate_lexer(const Options& opts, TokenMapping& tm) {
+    std::optional<LexerGeneration> generate_lexer(const Options& opts, const GenerationCache* cache, TokenMapping& tm) {
         std::string input;
         if (auto maybe_input = read_input(opts.lexer_src)) {
             input = std::move(maybe_input.value());
@@ -185,7 +270,14 @@ namespace {
             auto g = lexer_parser.parse();
             g.validate(er);
 
-            auto parallel_lexer = lexer::ParallelLexer(&g);
+            auto parallel_lexer = load_or_generate<lexer::ParallelLexer>(
+                cache,
+                "lexer",
+                input,
+                [&] { return lexer::ParallelLexer(&g); },
+                [&](CacheReader& r) { return lexer::ParallelLexer::load(r, g); },
+                [&](CacheWriter& w, const lexer::ParallelLexer& pl) { pl.save(w, g); }
+            );
 
             if (opts.verbose_lexer) {
                 parallel_lexer.dump_sizes(std::cout);
@@ -205,7 +297,12 @@ namespace {
         parser::llp::ParsingTable llp_table;
     };
 
-    std::optional<ParserGeneration> generate_parser(const Options& opts, TokenMapping& tm, bool derive_tokens) {
+    std::optional<ParserGeneration> generate_parser(
+        const Options& opts,
+        const GenerationCache* cache,
+        TokenMapping& tm,
+        bool derive_tokens
+    ) {
         std::string input;
         if (auto maybe_input = read_input(opts.parser_src)) {
             input = std::move(maybe_input.value());
@@ -222,21 +319,35 @@ namespace {
             if (opts.verbose_grammar)
                 g.dump(std::clog);
 
-            auto tsf = parser::TerminalSetFunctions(g);
-            if (opts.verbose_sets)
-                tsf.dump(std::clog);
+            auto generate = [&] {
+                auto tsf = parser::TerminalSetFunctions(g);
+                if (opts.verbose_sets)
+                    tsf.dump(std::clog);
 
-            auto gen = parser::llp::Generator(&er, &g, &tsf);
+                auto gen = parser::llp::Generator(&er, &g, &tsf, resolve_thread_count(opts.threads));
 
-            auto psls_table = gen.build_psls_table();
-            if (opts.verbose_psls)
-                psls_table.dump_csv(std::clog);
+                auto psls_table = gen.build_psls_table();
+                if (opts.verbose_psls)
+                    psls_table.dump_csv(std::clog);
 
-            auto ll_table = parser::ll::Generator(&er, &g, &tsf).build_parsing_table();
-            if (opts.verbose_ll)
-                ll_table.dump_csv(std::clog);
+                auto ll_table = parser::ll::Generator(&er, &g, &tsf).build_parsing_table();
+                if (opts.verbose_ll)
+                    ll_table.dump_csv(std::clog);
 
-            auto llp_table = gen.build_parsing_table(ll_table, psls_table);
+                return gen.build_parsing_table(ll_table, psls_table);
+            };
+
+            // The intermediate tables are not cached, so don't use the cache if any of them should be dumped.
+            bool dump_intermediates = opts.verbose_sets || opts.verbose_psls || opts.verbose_ll;
+
+            auto llp_table = load_or_generate<parser::llp::ParsingTable>(
+                dump_intermediates ? nullptr : cache,
+                "parser",
+                input,
+                generate,
+                [&](CacheReader& r) { return parser::llp::ParsingTable::load(r, g); },
+                [&](CacheWriter& w, const parser::llp::ParsingTable& pt) { pt.save(w, g); }
+            );
             if (opts.verbose_llp)
                 llp_table.dump_csv(std::clog);
 
@@ -257,6 +368,90 @@ namespace {
             return std::nullopt;
         }
     }
+
+    template <typename F>
+    auto timed(std::string_view what, F f) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = f();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        fmt::print("{}: {} us\n", what, elapsed.count());
+        return result;
+    }
+
+    // Lex and/or parse the test input using the host implementations of the lexer and parser.
+    bool run_test_input(
+        const Options& opts,
+        const std::optional<LexerGeneration>& lexer,
+        const std::optional<ParserGeneration>& parser
+    ) {
+        std::string input;
+        if (auto maybe_input = read_input(opts.test_input)) {
+            input = std::move(maybe_input.value());
+        } else {
+            return false;
+        }
+
+        auto threads = resolve_thread_count(opts.threads);
+        auto terminals = std::vector<parser::Terminal>();
+
+        // Only tokens which appear in the grammar can be passed to the parser.
+        auto find_terminal = [&](std::string_view name) -> std::optional<parser::Terminal> {
+            auto t = parser->grammar.symbols->find_terminal(name);
+            if (!t.has_value() || t->type != parser::Terminal::Type::USER_DEFINED)
+                return std::nullopt;
+            return t;
+        };
+
+        if (lexer.has_value()) {
+            auto interp = lexer::LexerInterpreter(&lexer->parallel_lexer, threads);
+            auto tokens = timed("Lexing", [&] { return interp.lex(input); });
+            fmt::print("Tokens: {}\n", tokens.size());
+
+            if (!tokens.empty() && !tokens.back().lexeme) {
+                fmt::print(std::cerr, "Error: Failed to lex test input at offset {}\n", tokens.back().offset);
+                return false;
+            }
+
+            if (parser.has_value()) {
+                auto lexeme_terminals = std::unordered_map<const lexer::Lexeme*, parser::Terminal>();
+                for (const auto& lexeme : lexer->grammar.lexemes) {
+                    if (auto t = find_terminal(lexeme.name))
+                        lexeme_terminals.insert({&lexeme, t.value()});
+                }
+
+                for (const auto& token : tokens) {
+                    auto it = lexeme_terminals.find(token.lexeme);
+                    if (it != lexeme_terminals.end())
+                        terminals.push_back(it->second);
+                }
+            }
+        } else if (parser.has_value()) {
+            auto names = std::istringstream(input);
+            auto name = std::string();
+            while (names >> name) {
+                auto t = find_terminal(name);
+                if (!t.has_value()) {
+                    fmt::print(std::cerr, "Error: Test input contains unknown token '{}'\n", name);
+                    return false;
+                }
+                terminals.push_back(t.value());
+            }
+        }
+
+        if (!parser.has_value())
+            return true;
+
+        auto interp = parser::llp::ParserInterpreter(&parser->grammar, &parser->llp_table, threads);
+        auto derivation = timed("Parsing", [&] { return interp.parse(terminals); });
+        if (!derivation.has_value()) {
+            fmt::print(std::cerr, "Error: Test input was rejected by the parser\n");
+            return false;
+        }
+
+        fmt::print("Productions: {}\n", derivation->size());
+        timed("Building parent vector", [&] { return interp.build_parent_vector(derivation.value()); });
+        return true;
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -270,32 +465,62 @@ int main(int argc, char* argv[]) {
 
     auto tm = TokenMapping();
 
-    auto lexer = opts.lexer_src ? generate_lexer(opts, tm) : std::nullopt;
-    auto parser = opts.parser_src ? generate_parser(opts, tm, !lexer.has_value()) : std::nullopt;
+    auto cache = std::optional<GenerationCache>();
+    if (opts.cache_dir) {
+        try {
+            cache.emplace(opts.cache_dir);
+        } catch (const CacheError& e) {
+            fmt::print(std::cerr, "Warning: {}, continuing without cache\n", e.what());
+        }
+    }
+
+    const auto* cache_ptr = cache.has_value() ? &cache.value() : nullptr;
+
+    auto lexer = opts.lexer_src ? generate_lexer(opts, cache_ptr, tm) : std::nullopt;
+    auto parser = opts.parser_src ? generate_parser(opts, cache_ptr, tm, !lexer.has_value()) : std::nullopt;
 
     // Only do this check here so we can report errors for both parser and lexer construction.
     if ((opts.lexer_src && !lexer.has_value()) || (opts.parser_src && !parser.has_value()))
         return EXIT_FAILURE;
 
+    if (opts.test_input && !run_test_input(opts, lexer, parser))
+        return EXIT_FAILURE;
+
     if (opts.check)
         return EXIT_SUCCESS;
 
     try {
-        auto renderer = pareas::Renderer(opts.namesp, opts.output);
+        if (opts.output) {
+            auto renderer = pareas::Renderer(opts.namesp, opts.output);
 
-        tm.render(renderer);
+            tm.render(renderer);
 
-        if (lexer.has_value()) {
-            auto lr = pareas::lexer::LexerRenderer(&renderer, &tm, &lexer->parallel_lexer);
-            lr.render();
-        }
+            if (lexer.has_value()) {
+                auto lr = pareas::lexer::LexerRenderer(&renderer, &tm, &lexer->parallel_lexer);
+                lr.render();
+            }
 
-        if (parser.has_value()) {
-            auto pr = pareas::parser::llp::ParserRenderer(&renderer, &tm, &parser->grammar, &parser->llp_table);
-            pr.render();
+            if (parser.has_value()) {
+                auto pr = pareas::parser::llp::ParserRenderer(&renderer, &tm, &parser->grammar, &parser->llp_table);
+                pr.render();
+            }
+
+            renderer.finalize();
         }
 
-        renderer.finalize();
+        if (opts.bundle) {
+            auto bw = pareas::BundleWriter(tm);
+
+            if (lexer.has_value()) {
+                bw.add_lexer(pareas::lexer::LexerTables(tm, lexer->parallel_lexer));
+            }
+
+            if (parser.has_value()) {
+                bw.add_parser(parser->grammar, pareas::parser::llp::ParserTables(tm, parser->grammar, parser->llp_table));
+            }
+
+            bw.write(opts.bundle);
+        }
     } catch (const RenderError& e) {
         fmt::print("Error: {}\n", e.what());
     }
@@ -9,16 +9,26 @@
 #include <algorithm>
 #include <cassert>
 
+namespace {
+    // The special terminals are given some name that makes them nice to print.
+    const std::string EMPTY_NAME = "ε";
+    const std::string START_OF_INPUT_NAME = "⊢";
+    const std::string END_OF_INPUT_NAME = "⊣";
+}
+
 namespace pareas::parser {
-    // Just give these some name that makes them nice to print
-    const Terminal Terminal::EMPTY = {Type::EMPTY, "ε"};
-    const Terminal Terminal::START_OF_INPUT = {Type::START_OF_INPUT, "⊢"};
-    const Terminal Terminal::END_OF_INPUT = {Type::END_OF_INPUT, "⊣"};
+    const Terminal Terminal::EMPTY = {Type::EMPTY, 0, &EMPTY_NAME};
+    const Terminal Terminal::START_OF_INPUT = {Type::START_OF_INPUT, 1, &START_OF_INPUT_NAME};
+    const Terminal Terminal::END_OF_INPUT = {Type::END_OF_INPUT, 2, &END_OF_INPUT_NAME};
+
+    const std::string& Terminal::name() const {
+        return *this->interned_name;
+    }
 
     Token Terminal::as_token() const {
         switch (this->type) {
             case Type::USER_DEFINED:
-                return {Token::Type::USER_DEFINED, this->name};
+                return {Token::Type::USER_DEFINED, this->name()};
             case Type::START_OF_INPUT:
                 return Token::START_OF_INPUT;
             case Type::END_OF_INPUT:
@@ -32,26 +42,28 @@ namespace pareas::parser {
         return this->type == Type::EMPTY;
     }
 
+    // The type of a terminal follows from its ID, so only the ID needs to be compared and hashed.
     bool Terminal::operator==(const Terminal& other) const {
-        return this->type == other.type && this->name == other.name;
+        return this->id == other.id;
     }
 
     size_t Terminal::Hash::operator()(const Terminal& t) const {
-        return pareas::hash_combine(
-            std::hash<Terminal::Type>{}(t.type),
-            std::hash<std::string>{}(t.name)
-        );
+        return std::hash<SymbolId>{}(t.id);
+    }
+
+    const std::string& NonTerminal::name() const {
+        return *this->interned_name;
     }
 
     bool NonTerminal::operator==(const NonTerminal& other) const {
-        return this->name == other.name;
+        return this->id == other.id;
     }
 
     size_t NonTerminal::Hash::operator()(const NonTerminal& nt) const {
-        return std::hash<std::string>{}(nt.name);
+        return std::hash<SymbolId>{}(nt.id);
     }
 
-    Symbol::Symbol(Terminal t): name(t.name) {
+    Symbol::Symbol(Terminal t): id(t.id), interned_name(t.interned_name) {
         switch (t.type) {
             case Terminal::Type::USER_DEFINED:
                 this->type = Type::USER_DEFINED_TERMINAL;
@@ -68,10 +80,14 @@ namespace pareas::parser {
         }
     }
 
-    Symbol::Symbol(NonTerminal nt): type(Type::NON_TERMINAL), name(nt.name) {}
+    Symbol::Symbol(NonTerminal nt): type(Type::NON_TERMINAL), id(nt.id), interned_name(nt.interned_name) {}
+
+    const std::string& Symbol::name() const {
+        return *this->interned_name;
+    }
 
     bool Symbol::operator==(const Symbol& other) const {
-        return this->type == other.type && this->name == other.name;
+        return this->type == other.type && this->id == other.id;
     }
 
     bool Symbol::is_empty_terminal() const {
@@ -85,13 +101,13 @@ namespace pareas::parser {
     Terminal Symbol::as_terminal() const {
         switch (this->type) {
             case Type::USER_DEFINED_TERMINAL:
-                return Terminal{Terminal::Type::USER_DEFINED, this->name};
+                return Terminal{Terminal::Type::USER_DEFINED, this->id, this->interned_name};
             case Type::EMPTY_TERMINAL:
-                return Terminal{Terminal::Type::EMPTY, this->name};
+                return Terminal::EMPTY;
             case Type::START_OF_INPUT_TERMINAL:
-                return Terminal{Terminal::Type::START_OF_INPUT, this->name};
+                return Terminal::START_OF_INPUT;
             case Type::END_OF_INPUT_TERMINAL:
-                return Terminal{Terminal::Type::END_OF_INPUT, this->name};
+                return Terminal::END_OF_INPUT;
             case Type::NON_TERMINAL:
                 assert(false); // Not a terminal
         }
@@ -99,16 +115,88 @@ namespace pareas::parser {
 
     NonTerminal Symbol::as_non_terminal() const {
         assert(this->type == Type::NON_TERMINAL);
-        return NonTerminal{this->name};
+        return NonTerminal{this->id, this->interned_name};
     }
 
     size_t Symbol::Hash::operator()(const Symbol& sym) const {
         return hash_combine(
-            std::hash<Symbol::Type>{}(sym.type),
-            std::hash<std::string>{}(sym.name)
+            std::hash<bool>{}(sym.is_terminal()),
+            std::hash<SymbolId>{}(sym.id)
         );
     }
 
+    SymbolId SymbolTable::Names::intern(std::string_view name) {
+        auto it = this->ids.find(name);
+        if (it != this->ids.end())
+            return it->second;
+
+        auto id = static_cast<SymbolId>(this->names.size());
+        const auto& stored = this->names.emplace_back(name);
+        this->ids.insert({stored, id});
+        return id;
+    }
+
+    std::optional<SymbolId> SymbolTable::Names::find(std::string_view name) const {
+        auto it = this->ids.find(name);
+        if (it == this->ids.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    SymbolTable::SymbolTable() {
+        for (const auto& t : {Terminal::EMPTY, Terminal::START_OF_INPUT, Terminal::END_OF_INPUT}) {
+            [[maybe_unused]] auto id = this->terminals.intern(t.name());
+            assert(id == t.id);
+        }
+    }
+
+    Terminal SymbolTable::intern_terminal(std::string_view name) {
+        return this->terminal(this->terminals.intern(name));
+    }
+
+    NonTerminal SymbolTable::intern_non_terminal(std::string_view name) {
+        return this->non_terminal(this->non_terminals.intern(name));
+    }
+
+    std::optional<Terminal> SymbolTable::find_terminal(std::string_view name) const {
+        if (auto id = this->terminals.find(name))
+            return this->terminal(id.value());
+        return std::nullopt;
+    }
+
+    std::optional<NonTerminal> SymbolTable::find_non_terminal(std::string_view name) const {
+        if (auto id = this->non_terminals.find(name))
+            return this->non_terminal(id.value());
+        return std::nullopt;
+    }
+
+    Terminal SymbolTable::terminal(SymbolId id) const {
+        switch (id) {
+            case 0:
+                return Terminal::EMPTY;
+            case 1:
+                return Terminal::START_OF_INPUT;
+            case 2:
+                return Terminal::END_OF_INPUT;
+            default:
+                assert(id < this->num_terminals());
+                return {Terminal::Type::USER_DEFINED, id, &this->terminals.names[id]};
+        }
+    }
+
+    NonTerminal SymbolTable::non_terminal(SymbolId id) const {
+        assert(id < this->num_non_terminals());
+        return {id, &this->non_terminals.names[id]};
+    }
+
+    size_t SymbolTable::num_terminals() const {
+        return this->terminals.names.size();
+    }
+
+    size_t SymbolTable::num_non_terminals() const {
+        return this->non_terminals.names.size();
+    }
+
     size_t Production::arity() const {
         size_t arity = 0;
         for (const auto& sym : this->rhs) {
@@ -120,6 +208,9 @@ namespace pareas::parser {
 
     void Grammar::dump(std::ostream& os) const {
         os << "Start symbol: " << this->start()->lhs << " " << std::endl;
+        for (const auto& list : this->operator_lists) {
+            os << list << std::endl;
+        }
         for (const auto& prod : this->productions) {
             os << prod << std::endl;
         }
@@ -129,6 +220,7 @@ namespace pareas::parser {
         // Tag uniqueness is already checked by the grammar parser, so skip that here.
         bool error = !this->check_production_definitions(er);
         error |= !this->check_start_rule(er);
+        error |= !this->check_operator_lists(er);
 
         if (error)
             throw InvalidGrammarError("Invalid grammar");
@@ -162,7 +254,7 @@ namespace pareas::parser {
                     continue;
 
                 error = true;
-                er.error(prod.loc, fmt::format("Undefined token '{}'", sym.name));
+                er.error(prod.loc, fmt::format("Undefined token '{}'", sym.name()));
             }
         }
 
@@ -179,6 +271,23 @@ namespace pareas::parser {
         return int_bit_width(this->productions.size() - 1);
     }
 
+    const OperatorList* Grammar::operator_list(const Production* p) const {
+        for (const auto& list : this->operator_lists) {
+            if (list.nt == p->lhs)
+                return &list;
+        }
+
+        return nullptr;
+    }
+
+    OperatorListRole Grammar::operator_list_role(const Production* p) const {
+        if (!this->operator_list(p))
+            return OperatorListRole::NONE;
+
+        // The form of the productions is checked by `check_operator_lists`.
+        return p->rhs.empty() ? OperatorListRole::END : OperatorListRole::OPERATOR;
+    }
+
     bool Grammar::check_production_definitions(ErrorReporter& er) const {
         bool error = false;
 
@@ -196,7 +305,7 @@ namespace pareas::parser {
                 if (sym.is_terminal() || exists(sym.as_non_terminal()))
                     continue;
 
-                er.error(prod.loc, fmt::format("Missing rule definition for '{}'", sym.name));
+                er.error(prod.loc, fmt::format("Missing rule definition for '{}'", sym.name()));
                 error = true;
             }
         }
@@ -239,19 +348,71 @@ namespace pareas::parser {
         return !error;
     }
 
+    bool Grammar::check_operator_lists(ErrorReporter& er) const {
+        bool error = false;
+
+        for (const auto& list : this->operator_lists) {
+            const auto* first = &*std::find_if(
+                this->operator_lists.begin(),
+                this->operator_lists.end(),
+                [&](const auto& other) { return other.nt == list.nt; }
+            );
+
+            if (first != &list) {
+                er.error(list.loc, fmt::format("Duplicate operator list declaration for '{}'", list.nt));
+                er.note(first->loc, "First declared here");
+                error = true;
+                continue;
+            }
+
+            bool defined = false;
+            bool has_end = false;
+
+            for (const auto& prod : this->productions) {
+                if (prod.lhs != list.nt)
+                    continue;
+
+                defined = true;
+                if (prod.rhs.empty()) {
+                    has_end = true;
+                    continue;
+                }
+
+                // An operator must recurse into the list with its last symbol, and nowhere else.
+                auto occurrences = std::count(prod.rhs.begin(), prod.rhs.end(), Symbol(list.nt));
+                if (prod.rhs.back() != Symbol(list.nt) || occurrences != 1) {
+                    er.error(prod.loc, fmt::format("Production of operator list '{}' not in correct form", list.nt));
+                    er.note(prod.loc, fmt::format("Expected form {0} -> ... {0}; or {0} -> ;", list.nt));
+                    error = true;
+                }
+            }
+
+            if (!defined) {
+                er.error(list.loc, fmt::format("Missing rule definition for '{}'", list.nt));
+                error = true;
+            } else if (!has_end) {
+                er.error(list.loc, fmt::format("Operator list '{}' has no end production", list.nt));
+                er.note(list.loc, fmt::format("Expected a production of the form {} -> ;", list.nt));
+                error = true;
+            }
+        }
+
+        return !error;
+    }
+
     std::ostream& operator<<(std::ostream& os, const Terminal& t) {
-        return os << t.name;
+        return os << t.name();
     }
 
     std::ostream& operator<<(std::ostream& os, const NonTerminal& nt) {
-        return os << nt.name;
+        return os << nt.name();
     }
 
     std::ostream& operator<<(std::ostream& os, const Symbol& sym) {
         if (sym.is_terminal())
-            return os << '\'' << sym.name << '\'';
+            return os << '\'' << sym.name() << '\'';
         else
-            return os << sym.name;
+            return os << sym.name();
     }
 
     std::ostream& operator<<(std::ostream& os, const Production& prod) {
@@ -266,13 +427,16 @@ namespace pareas::parser {
         return os;
     }
 
-    namespace literals {
-        Terminal operator ""_t(const char* name, size_t len) {
-            return Terminal{Terminal::Type::USER_DEFINED, std::string(name, len)};
+    std::ostream& operator<<(std::ostream& os, const OperatorList& list) {
+        switch (list.assoc) {
+            case OperatorList::Associativity::LEFT:
+                os << "%left ";
+                break;
+            case OperatorList::Associativity::RIGHT:
+                os << "%right ";
+                break;
         }
 
-        NonTerminal operator ""_nt(const char* name, size_t len) {
-            return NonTerminal{std::string(name, len)};
-        }
+        return os << list.nt;
     }
 }
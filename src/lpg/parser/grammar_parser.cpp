@@ -7,7 +7,7 @@
 
 namespace pareas::parser {
     GrammarParser::GrammarParser(Parser* parser):
-        parser(parser) {}
+        parser(parser), symbols(std::make_shared<SymbolTable>()) {}
 
     Grammar GrammarParser::parse() {
         bool error = false;
@@ -15,7 +15,8 @@ namespace pareas::parser {
         this->parser->eat_delim();
 
         while (auto c = this->parser->peek()) {
-            if (!this->production()) {
+            bool ok = c == '%' ? this->operator_list_declaration() : this->production();
+            if (!ok) {
                 error = true;
                 this->parser->skip_until(';');
             }
@@ -33,7 +34,7 @@ namespace pareas::parser {
         if (error)
             throw GrammarParseError();
 
-        auto g = Grammar{std::move(this->productions)};
+        auto g = Grammar{std::move(this->productions), std::move(this->operator_lists), std::move(this->symbols)};
         g.validate(*this->parser->er);
         return g;
     }
@@ -71,12 +72,12 @@ namespace pareas::parser {
                 auto t = this->terminal();
                 if (t.size() == 0)
                     return false;
-                syms.push_back(Terminal{Terminal::Type::USER_DEFINED, std::string(t)});
+                syms.push_back(this->symbols->intern_terminal(t));
             } else if (this->parser->is_word_start_char(c.value())) {
                 auto nt = this->parser->word();
                 if (nt.size() == 0)
                     return false;
-                syms.push_back(NonTerminal{std::string(nt)});
+                syms.push_back(this->symbols->intern_non_terminal(nt));
             } else {
                 break;
             }
@@ -101,10 +102,54 @@ namespace pareas::parser {
             return false;
         }
 
-        this->productions.push_back({lhs_loc, std::string(tag), NonTerminal{std::string(lhs)}, syms});
+        this->productions.push_back({lhs_loc, std::string(tag), this->symbols->intern_non_terminal(lhs), syms});
         return true;
     }
 
+    bool GrammarParser::operator_list_declaration() {
+        if (!this->parser->expect('%'))
+            return false;
+
+        auto keyword_loc = this->parser->loc();
+        auto keyword = this->parser->word();
+        if (keyword.size() == 0)
+            return false;
+
+        auto assoc = OperatorList::Associativity::LEFT;
+        if (keyword == "left") {
+            assoc = OperatorList::Associativity::LEFT;
+        } else if (keyword == "right") {
+            assoc = OperatorList::Associativity::RIGHT;
+        } else {
+            this->parser->er->error(keyword_loc, fmt::format("Unknown declaration '%{}'", keyword));
+            return false;
+        }
+
+        this->parser->eat_delim();
+
+        size_t declared = 0;
+        while (auto c = this->parser->peek()) {
+            if (!this->parser->is_word_start_char(c.value()))
+                break;
+
+            auto nt_loc = this->parser->loc();
+            auto nt = this->parser->word();
+            if (nt.size() == 0)
+                return false;
+
+            this->operator_lists.push_back({nt_loc, this->symbols->intern_non_terminal(nt), assoc});
+            ++declared;
+            this->parser->eat_delim();
+        }
+
+        if (declared == 0) {
+            this->parser->er->error(this->parser->loc(), fmt::format("Expected non-terminal after '%{}'", keyword));
+            return false;
+        }
+
+        return this->parser->expect(';');
+    }
+
     std::string_view GrammarParser::terminal() {
         if (!this->parser->expect('\''))
             return "";
@@ -22,7 +22,7 @@ namespace pareas::parser::ll {
         };
 
         for (const auto& prod : this->g->productions) {
-            auto first = this->tsf->compute_first(prod.rhs);
+            const auto& first = this->tsf->first_of_suffix(prod, 0);
 
             bool has_empty = false;
             for (const auto& t : first) {
@@ -45,6 +45,7 @@ namespace pareas::parser::ll {
         if (error)
             throw ConflictError();
 
+        ll.compute_expansions();
         return ll;
     }
 }
@@ -4,6 +4,7 @@
 #include <fmt/ostream.h>
 
 #include <unordered_set>
+#include <cassert>
 
 namespace pareas::parser::ll {
         size_t State::Hash::operator()(const State& key) const {
@@ -30,19 +31,63 @@ namespace pareas::parser::ll {
                 break;
             }
 
-            auto nt = top.as_non_terminal();
+            auto it = this->expansions.find({top.as_non_terminal(), y});
+            assert(it != this->expansions.end());
+            const auto& expansion = it->second;
 
-            auto it = this->table.find({nt, y});
-            assert(it != this->table.end());
-            productions.push_back(it->second);
-            const auto& to_push = it->second->rhs;
-
-            stack.insert(stack.end(), to_push.rbegin(), to_push.rend());
+            productions.insert(productions.end(), expansion.productions.begin(), expansion.productions.end());
+            if (expansion.matched) {
+                stack.insert(stack.end(), expansion.residue.begin(), expansion.residue.end());
+                break;
+            }
         }
 
         return productions;
     }
 
+    void ParsingTable::compute_expansions() {
+        this->expansions.clear();
+        for (const auto& [state, prod] : this->table)
+            this->expand(state);
+    }
+
+    const ParsingTable::Expansion& ParsingTable::expand(const State& state) {
+        auto it = this->expansions.find(state);
+        if (it != this->expansions.end())
+            return it->second;
+
+        auto table_it = this->table.find(state);
+        assert(table_it != this->table.end());
+        const auto* prod = table_it->second;
+        const auto& rhs = prod->rhs;
+
+        auto expansion = Expansion{{prod}, {}, false};
+        for (size_t i = 0; i < rhs.size(); ++i) {
+            const auto& sym = rhs[i];
+            if (sym.is_empty_terminal())
+                continue;
+
+            if (sym.is_terminal()) {
+                assert(state.lookahead == sym.as_terminal());
+            } else {
+                // References to elements of an unordered_map remain valid when it grows.
+                const auto& sub = this->expand({sym.as_non_terminal(), state.lookahead});
+                expansion.productions.insert(expansion.productions.end(), sub.productions.begin(), sub.productions.end());
+                if (!sub.matched)
+                    continue;
+
+                expansion.residue = sub.residue;
+            }
+
+            // The remainder of the right hand side is left on the stack, below whatever was left by `sym`.
+            expansion.residue.insert(expansion.residue.begin(), rhs.rbegin(), rhs.rend() - i - 1);
+            expansion.matched = true;
+            break;
+        }
+
+        return this->expansions.insert({state, std::move(expansion)}).first->second;
+    }
+
     void ParsingTable::dump_csv(std::ostream& os) const {
         auto nts = std::unordered_set<NonTerminal, NonTerminal::Hash>();
         auto ts = std::unordered_set<Terminal, Terminal::Hash>();
@@ -1,15 +1,31 @@
 #include "pareas/lpg/parser/llp/generator.hpp"
 
+#include "pareas/lpg/parallel_util.hpp"
+#include "pareas/lpg/hash_util.hpp"
+
 #include <fmt/ostream.h>
 
 #include <iostream>
 #include <deque>
+#include <unordered_set>
+#include <unordered_map>
 #include <algorithm>
 #include <cassert>
 
 namespace pareas::parser::llp {
-    Generator::Generator(ErrorReporter* er, const Grammar* g, const TerminalSetFunctions* tsf):
-        er(er), g(g), tsf(tsf) {}
+    bool Generator::PendingGamma::operator==(const PendingGamma& other) const {
+        return this->sym == other.sym && this->delta == other.delta && this->len == other.len;
+    }
+
+    size_t Generator::PendingGamma::Hash::operator()(const PendingGamma& pg) const {
+        size_t hash = Symbol::Hash{}(pg.sym);
+        hash = pareas::hash_combine(hash, std::hash<GammaId>{}(pg.delta));
+        hash = pareas::hash_combine(hash, std::hash<uint32_t>{}(pg.len));
+        return hash;
+    }
+
+    Generator::Generator(ErrorReporter* er, const Grammar* g, const TerminalSetFunctions* tsf, size_t threads):
+        er(er), g(g), tsf(tsf), threads(threads) {}
 
     PSLSTable Generator::build_psls_table() {
         this->compute_item_sets();
@@ -20,14 +36,15 @@ namespace pareas::parser::llp {
         auto insert = [&](const Item& item) {
             auto ap = AdmissiblePair{item.lookback, item.lookahead};
             auto it = psls.table.find(ap);
+            auto item_gamma = this->gammas[item.gamma];
 
             if (it == psls.table.end()) {
-                psls.table.insert(it, {ap, {item.gamma, item.prod}});
+                psls.table.insert(it, {ap, {{item_gamma.begin(), item_gamma.end()}, item.prod}});
                 return;
             }
 
             const auto& gamma = it->second.gamma;
-            if (std::equal(gamma.begin(), gamma.end(), item.gamma.begin(), item.gamma.end()))
+            if (std::equal(gamma.begin(), gamma.end(), item_gamma.begin(), item_gamma.end()))
                 return;
 
             this->er->error(item.prod->loc, fmt::format("PSLS conflict between terminals '{}' and '{}', grammar is not LLP(1, 1)", ap.x, ap.y));
@@ -38,8 +55,8 @@ namespace pareas::parser::llp {
             error = true;
         };
 
-        for (const auto& set : this->item_sets) {
-            for (const auto& item : set.items) {
+        for (ItemSetId id = 0; id < this->item_sets.size(); ++id) {
+            for (const auto& item : this->item_sets[id]) {
                 if (item.is_dot_at_begin())
                     continue;
                 const auto& sym = item.sym_before_dot();
@@ -61,8 +78,30 @@ namespace pareas::parser::llp {
     ParsingTable Generator::build_parsing_table(const ll::ParsingTable& ll, const PSLSTable& psls) {
         auto llp = ParsingTable();
 
-        for (const auto& [ap, entry] : psls.table) {
-            if (entry.prod == this->g->start()) {
+        // The entries are independent, so they are computed in parallel and inserted afterwards.
+        auto psls_entries = std::vector<std::pair<AdmissiblePair, const PSLSTable::Entry*>>();
+        psls_entries.reserve(psls.table.size());
+        for (const auto& [ap, entry] : psls.table)
+            psls_entries.push_back({ap, &entry});
+
+        auto llp_entries = std::vector<ParsingTable::Entry>(psls_entries.size());
+
+        // All entries of the start rule begin by parsing the left delimiter (see below), so do that only once.
+        auto start_stack = std::vector<Symbol>();
+        auto start_productions = std::vector<const Production*>();
+        bool has_start_entries = std::any_of(psls_entries.begin(), psls_entries.end(), [&](const auto& pair) {
+            return pair.second->prod == this->g->start();
+        });
+        if (has_start_entries) {
+            start_stack.push_back(this->g->start()->lhs);
+            start_productions = ll.partial_parse(Terminal::START_OF_INPUT, start_stack);
+        }
+
+        parallel_for(this->threads, psls_entries.size(), [&](size_t i) {
+            const auto& [ap, entry] = psls_entries[i];
+            auto& llp_entry = llp_entries[i];
+
+            if (entry->prod == this->g->start()) {
                 assert(ap.x == Terminal::START_OF_INPUT);
                 // In order to make the LLP table a bit more concise, we do a hack here:
                 // Instead of generating the parse from the left delimiter, we generate
@@ -77,78 +116,116 @@ namespace pareas::parser::llp {
                 // omitted. It would be harder to fix that up in the renderer when the above
                 // change is applied, so instead, we simply set the initial stack of any
                 // admissible pair with x = left delimiter to empty.
-                auto stack = std::vector<Symbol>({this->g->start()->lhs});
-                auto prod1 = ll.partial_parse(ap.x, stack);
+                auto stack = start_stack;
+                auto prod1 = start_productions;
                 auto prod2 = ll.partial_parse(ap.y, stack);
                 prod1.insert(prod1.end(), prod2.begin(), prod2.end());
-                llp.table[ap] = {{}, stack, prod1};
+                llp_entry = {{}, std::move(stack), std::move(prod1)};
             } else {
-                auto initial_stack = std::vector<Symbol>(entry.gamma.rbegin(), entry.gamma.rend());
+                auto initial_stack = std::vector<Symbol>(entry->gamma.rbegin(), entry->gamma.rend());
                 auto stack = initial_stack;
                 auto productions = ll.partial_parse(ap.y, stack);
-                llp.table[ap] = {initial_stack, stack, productions};
+                llp_entry = {std::move(initial_stack), std::move(stack), std::move(productions)};
             }
-        }
+        });
+
+        for (size_t i = 0; i < psls_entries.size(); ++i)
+            llp.table[psls_entries[i].first] = std::move(llp_entries[i]);
 
         return llp;
     }
 
     void Generator::dump(std::ostream& os) {
         fmt::print(os, "Item sets:\n");
-        for (const auto& set : this->item_sets) {
-            set.dump(os);
+        for (ItemSetId id = 0; id < this->item_sets.size(); ++id) {
+            ItemSet{this->item_sets[id]}.dump(os, this->gammas);
         }
     }
 
     void Generator::compute_item_sets() {
-        if (!this->item_sets.empty())
+        if (this->item_sets.size() != 0)
             return; // Already computed
 
-        auto queue = std::deque<ItemSet>();
-
-        auto enqueue = [&](const ItemSet& set) {
-            bool inserted = this->item_sets.insert(set).second;
-            if (inserted) {
-                queue.emplace_back(set);
-            }
-        };
-
         {
-            auto initial = ItemSet();
-            initial.items.insert({
+            auto initial = std::vector<Item>({{
                 .prod = this->g->start(),
-                .dot = this->g->start()->rhs.size(),
+                .dot = static_cast<uint32_t>(this->g->start()->rhs.size()),
                 .lookback = Terminal::END_OF_INPUT,
                 .lookahead = Terminal::EMPTY,
-                .gamma = {},
-            });
+                .gamma = this->gammas.insert({}).first,
+            }});
 
-            enqueue(initial);
+            this->item_sets.insert(initial);
         }
 
-        while (!queue.empty()) {
-            auto set = queue.front();
-            queue.pop_front();
+        // The item sets are explored in breadth-first order, one level at a time. The sets of the current level
+        // are expanded in parallel, which only reads from the arenas. The new gammas and sets are then added to
+        // the arenas sequentially, in the order of the sets and symbols which produced them. This yields the same
+        // IDs as exploring the sets one by one, regardless of the number of threads.
+        ItemSetId level_begin = 0;
+        while (level_begin < this->item_sets.size()) {
+            ItemSetId level_end = this->item_sets.size();
+
+            auto expansions = std::vector<std::vector<Expansion>>(level_end - level_begin);
+            parallel_for(this->threads, expansions.size(), [&](size_t i) {
+                auto set = ItemSet{this->item_sets[level_begin + i]};
+                for (const auto& sym : set.syms_before_dots()) {
+                    auto expansion = this->predecessor(set, sym);
+                    this->closure(expansion.items);
+                    expansions[i].push_back(std::move(expansion));
+                }
+            });
 
-            auto syms = set.syms_before_dots();
-            for (const auto& sym : syms) {
-                auto new_set = this->predecessor(set, sym);
-                this->closure(new_set);
-                enqueue(new_set);
+            // Intern the new gammas, and remember the resulting ID for each expansion.
+            auto gamma_ids = std::vector<std::vector<GammaId>>();
+            auto x_delta = std::vector<Symbol>();
+            for (const auto& set_expansions : expansions) {
+                for (const auto& expansion : set_expansions) {
+                    auto& ids = gamma_ids.emplace_back();
+                    for (const auto& pg : expansion.gammas) {
+                        x_delta.clear();
+                        x_delta.push_back(pg.sym);
+                        auto delta = this->gammas[pg.delta];
+                        x_delta.insert(x_delta.end(), delta.begin(), delta.begin() + (pg.len - 1));
+                        ids.push_back(this->gammas.insert(x_delta).first);
+                    }
+                }
             }
+
+            // Replace the gamma indices by IDs, and bring the sets into canonical form.
+            auto offsets = std::vector<size_t>(expansions.size() + 1, 0);
+            for (size_t i = 0; i < expansions.size(); ++i)
+                offsets[i + 1] = offsets[i] + expansions[i].size();
+
+            parallel_for(this->threads, expansions.size(), [&](size_t i) {
+                for (size_t j = 0; j < expansions[i].size(); ++j) {
+                    auto& items = expansions[i][j].items;
+                    const auto& ids = gamma_ids[offsets[i] + j];
+                    for (auto& item : items)
+                        item.gamma = ids[item.gamma];
+                    ItemSet::canonicalize(items);
+                }
+            });
+
+            for (const auto& set_expansions : expansions) {
+                for (const auto& expansion : set_expansions)
+                    this->item_sets.insert(expansion.items);
+            }
+
+            level_begin = level_end;
         }
     }
 
-    ItemSet Generator::predecessor(const ItemSet& set, const Symbol& sym) {
-        auto new_set = ItemSet();
+    Generator::Expansion Generator::predecessor(const ItemSet& set, const Symbol& sym) const {
+        auto expansion = Expansion();
+        auto pending_indices = std::unordered_map<PendingGamma, GammaId, PendingGamma::Hash>();
+
         for (const auto& item : set.items) {
             if (item.is_dot_at_begin() || item.sym_before_dot() != sym)
                 continue;
 
-            auto alpha = item.syms_before_dot();
-            alpha = alpha.subspan(0, alpha.size() - 1);
-
-            auto us = this->tsf->compute_last(alpha);
+            // The symbols before the dot, except for `sym` itself.
+            auto us = this->tsf->last_of_prefix(*item.prod, item.dot - 1);
             if (us.contains(Terminal::EMPTY)) {
                 const auto& before = this->tsf->before(item.prod->lhs);
                 if (!before.empty()) // Special case: Start rule
@@ -159,37 +236,45 @@ namespace pareas::parser::llp {
             Symbol xvi[] = {sym, item.lookahead};
             auto vs = this->tsf->compute_first(xvi);
 
-            for (const auto& u : us) {
-                for (const auto& v : vs) {
-                    auto gamma = this->compute_gamma(v, sym, item.gamma);
-                    new_set.items.insert({
+            for (const auto& v : vs) {
+                // Gamma only depends on v, so compute it once for all u.
+                auto pg = PendingGamma{sym, item.gamma, this->compute_gamma_len(v, sym, this->gammas[item.gamma])};
+                auto [it, inserted] = pending_indices.insert({pg, static_cast<GammaId>(expansion.gammas.size())});
+                if (inserted)
+                    expansion.gammas.push_back(pg);
+
+                for (const auto& u : us) {
+                    expansion.items.push_back({
                         .prod = item.prod,
                         .dot = item.dot - 1,
                         .lookback = u,
                         .lookahead = v,
-                        .gamma = gamma,
+                        .gamma = it->second,
                     });
                 }
             }
         }
 
-        return new_set;
+        return expansion;
     }
 
-    void Generator::closure(ItemSet& set) {
+    void Generator::closure(std::vector<Item>& items) const {
+        auto seen = std::unordered_set<Item, Item::Hash>();
         auto queue = std::deque<Item>();
 
         auto enqueue = [&](const Item& item) {
-            bool inserted = set.items.insert(item).second;
-            if (item.is_dot_at_begin() || item.sym_before_dot().is_terminal() || !inserted)
+            if (!seen.insert(item).second)
+                return;
+            items.push_back(item);
+            if (item.is_dot_at_begin() || item.sym_before_dot().is_terminal())
                 return;
             queue.push_back(item);
         };
 
-        for (const auto& item : set.items) {
-            if (!item.is_dot_at_begin() && !item.sym_before_dot().is_terminal())
-                queue.push_back(item);
-        }
+        auto initial = std::move(items);
+        items.clear();
+        for (const auto& item : initial)
+            enqueue(item);
 
         while (!queue.empty()) {
             auto item = queue.front();
@@ -202,7 +287,7 @@ namespace pareas::parser::llp {
                 if (prod.lhs != nt)
                     continue;
 
-                auto us = this->tsf->compute_last(std::span(prod.rhs));
+                auto us = this->tsf->last_of_prefix(prod, prod.rhs.size());
                 if (us.contains(Terminal::EMPTY)) {
                     us.erase(Terminal::EMPTY);
                     merge_terminal_sets_omit_empty(us, this->tsf->before(prod.lhs));
@@ -211,7 +296,7 @@ namespace pareas::parser::llp {
                 for (const auto& u : us) {
                     enqueue({
                         .prod = &prod,
-                        .dot = prod.rhs.size(),
+                        .dot = static_cast<uint32_t>(prod.rhs.size()),
                         .lookback = u,
                         .lookahead = item.lookahead,
                         .gamma = item.gamma,
@@ -221,27 +306,21 @@ namespace pareas::parser::llp {
         }
     }
 
-    std::vector<Symbol> Generator::compute_gamma(const Terminal& v, const Symbol& x, std::span<const Symbol> delta) {
+    uint32_t Generator::compute_gamma_len(const Terminal& v, const Symbol& x, std::span<const Symbol> delta) const {
         assert(!x.is_empty_terminal());
         assert(!v.is_empty());
 
-        auto x_delta = std::vector<Symbol>();
-        x_delta.push_back(x);
-        x_delta.insert(x_delta.end(), delta.begin(), delta.end());
-
-        auto gamma = std::vector<Symbol>();
-        for (const auto& sym : x_delta) {
-            gamma.push_back(sym);
+        // Gamma is the shortest prefix of x followed by delta that ends with a symbol that can start with v.
+        for (size_t i = 0; i <= delta.size(); ++i) {
+            const auto& sym = i == 0 ? x : delta[i - 1];
             if (sym.is_terminal()) {
                 assert(sym.as_terminal() == v);
-                return gamma;
+                return i + 1;
             }
 
-            auto nt = sym.as_non_terminal();
-
-            const auto first = this->tsf->first(nt);
+            const auto& first = this->tsf->first(sym.as_non_terminal());
             if (first.contains(v)) {
-                return gamma;
+                return i + 1;
             }
 
             assert(first.contains(Terminal::EMPTY));
@@ -0,0 +1,166 @@
+#include "pareas/lpg/parser/llp/interpreter.hpp"
+#include "pareas/lpg/parallel_util.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace pareas::parser::llp {
+    ParserInterpreter::ParserInterpreter(const Grammar* g, const ParsingTable* llp_table, size_t threads):
+        g(g), threads(threads), num_terminals(0) {
+        for (const auto& [ap, entry] : llp_table->table)
+            this->num_terminals = std::max<size_t>({this->num_terminals, ap.x.id + 1, ap.y.id + 1});
+
+        this->entries.resize(this->num_terminals * this->num_terminals, nullptr);
+        for (const auto& [ap, entry] : llp_table->table)
+            this->entries[ap.x.id * this->num_terminals + ap.y.id] = &entry;
+
+        this->arities.reserve(g->productions.size());
+        for (const auto& prod : g->productions)
+            this->arities.push_back(prod.arity());
+    }
+
+    auto ParserInterpreter::parse(std::span<const Terminal> input) const -> std::optional<std::vector<const Production*>> {
+        // The input is delimited by the start- and end-of-input terminals, so there are input.size() + 1 pairs.
+        auto terminal = [&](size_t i) {
+            if (i == 0)
+                return Terminal::START_OF_INPUT;
+            else if (i <= input.size())
+                return input[i - 1];
+            return Terminal::END_OF_INPUT;
+        };
+
+        struct ChunkResult {
+            bool accepted = true;
+            // The right brackets which are not matched within the chunk, in order of appearance.
+            std::vector<Symbol> unmatched_right;
+            // The left brackets which are not matched within the chunk. This is the stack at the end of the chunk,
+            // so the last of these is the first to be matched.
+            std::vector<Symbol> unmatched_left;
+            std::vector<const Production*> derivation;
+        };
+
+        auto chunking = Chunking(this->threads, input.size() + 1, MIN_CHUNK_SIZE);
+        auto chunks = std::vector<ChunkResult>(chunking.chunks);
+
+        parallel_for(this->threads, chunking.chunks, [&](size_t i) {
+            auto& chunk = chunks[i];
+
+            for (size_t j = chunking.begin(i); j < chunking.end(i); ++j) {
+                const auto* entry = this->lookup(terminal(j), terminal(j + 1));
+                if (!entry) {
+                    chunk.accepted = false;
+                    return;
+                }
+
+                // The initial stack is popped top-first, so its symbols appear as right brackets in reverse.
+                for (auto it = entry->initial_stack.rbegin(); it != entry->initial_stack.rend(); ++it) {
+                    if (chunk.unmatched_left.empty()) {
+                        chunk.unmatched_right.push_back(*it);
+                    } else if (chunk.unmatched_left.back() != *it) {
+                        chunk.accepted = false;
+                        return;
+                    } else {
+                        chunk.unmatched_left.pop_back();
+                    }
+                }
+
+                chunk.unmatched_left.insert(chunk.unmatched_left.end(), entry->final_stack.begin(), entry->final_stack.end());
+                chunk.derivation.insert(chunk.derivation.end(), entry->productions.begin(), entry->productions.end());
+            }
+        });
+
+        // Match the remaining brackets of all chunks, and compute the offset of the derivation of each chunk.
+        auto stack = std::vector<Symbol>();
+        auto offsets = std::vector<size_t>(chunking.chunks);
+        size_t num_productions = 0;
+
+        for (size_t i = 0; i < chunking.chunks; ++i) {
+            const auto& chunk = chunks[i];
+            if (!chunk.accepted)
+                return std::nullopt;
+
+            for (const auto& sym : chunk.unmatched_right) {
+                if (stack.empty() || stack.back() != sym)
+                    return std::nullopt;
+                stack.pop_back();
+            }
+
+            stack.insert(stack.end(), chunk.unmatched_left.begin(), chunk.unmatched_left.end());
+
+            offsets[i] = num_productions;
+            num_productions += chunk.derivation.size();
+        }
+
+        if (!stack.empty())
+            return std::nullopt;
+
+        auto derivation = std::vector<const Production*>(num_productions);
+        parallel_for(this->threads, chunking.chunks, [&](size_t i) {
+            std::copy(chunks[i].derivation.begin(), chunks[i].derivation.end(), derivation.begin() + offsets[i]);
+        });
+
+        return derivation;
+    }
+
+    std::vector<int64_t> ParserInterpreter::build_parent_vector(std::span<const Production* const> derivation) const {
+        // This is again a bracket matching problem: every production opens a bracket for each of the non-terminals
+        // on its right hand side, and every production except the root closes the innermost open bracket, which
+        // belongs to its parent. The open brackets of a production are stored together.
+        struct OpenBrackets {
+            size_t node;
+            size_t remaining;
+        };
+
+        struct ChunkResult {
+            // The productions of which the parent lies in a previous chunk, in order of appearance.
+            std::vector<size_t> orphans;
+            std::vector<OpenBrackets> open;
+        };
+
+        auto parents = std::vector<int64_t>(derivation.size(), NO_PARENT);
+
+        auto chunking = Chunking(this->threads, derivation.size(), MIN_CHUNK_SIZE);
+        auto chunks = std::vector<ChunkResult>(chunking.chunks);
+
+        auto close = [&](std::vector<OpenBrackets>& open, size_t node) {
+            assert(!open.empty());
+            parents[node] = open.back().node;
+            if (--open.back().remaining == 0)
+                open.pop_back();
+        };
+
+        parallel_for(this->threads, chunking.chunks, [&](size_t i) {
+            auto& chunk = chunks[i];
+
+            for (size_t j = chunking.begin(i); j < chunking.end(i); ++j) {
+                if (j == 0) {
+                    // The root has no parent.
+                } else if (chunk.open.empty()) {
+                    chunk.orphans.push_back(j);
+                } else {
+                    close(chunk.open, j);
+                }
+
+                auto arity = this->arities[this->g->production_id(derivation[j])];
+                if (arity > 0)
+                    chunk.open.push_back({j, arity});
+            }
+        });
+
+        auto open = std::vector<OpenBrackets>();
+        for (const auto& chunk : chunks) {
+            for (auto node : chunk.orphans)
+                close(open, node);
+            open.insert(open.end(), chunk.open.begin(), chunk.open.end());
+        }
+
+        assert(open.empty());
+        return parents;
+    }
+
+    const ParsingTable::Entry* ParserInterpreter::lookup(const Terminal& x, const Terminal& y) const {
+        if (x.id >= this->num_terminals || y.id >= this->num_terminals)
+            return nullptr;
+        return this->entries[x.id * this->num_terminals + y.id];
+    }
+}
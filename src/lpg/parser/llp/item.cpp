@@ -4,6 +4,7 @@
 #include <fmt/ostream.h>
 
 #include <algorithm>
+#include <tuple>
 #include <stdexcept>
 #include <cassert>
 
@@ -39,10 +40,17 @@ namespace pareas::parser::llp {
             lhs.dot == rhs.dot &&
             lhs.lookahead == rhs.lookahead &&
             lhs.lookback == rhs.lookback &&
-            std::equal(lhs.gamma.begin(), lhs.gamma.end(), rhs.gamma.begin(), rhs.gamma.end());
+            lhs.gamma == rhs.gamma;
     }
 
-    std::ostream& operator<<(std::ostream& os, const Item& item) {
+    bool operator<(const Item& lhs, const Item& rhs) {
+        auto key = [](const Item& item) {
+            return std::make_tuple(item.prod, item.dot, item.lookback.id, item.lookahead.id, item.gamma);
+        };
+        return key(lhs) < key(rhs);
+    }
+
+    void dump_item(std::ostream& os, const Item& item, const GammaArena& gammas) {
         fmt::print(os, "[{} ->", Symbol(item.prod->lhs));
 
         for (size_t i = 0; i < item.prod->rhs.size(); ++i) {
@@ -56,24 +64,24 @@ namespace pareas::parser::llp {
 
         fmt::print(os, ", {}, {},", item.lookback, item.lookahead);
 
-        if (item.gamma.empty()) {
+        auto gamma = gammas[item.gamma];
+        if (gamma.empty()) {
             fmt::print(os, " ε");
         } else {
-            for (const auto& sym : item.gamma) {
+            for (const auto& sym : gamma) {
                 fmt::print(os, " {}", sym);
             }
         }
 
         fmt::print(os, "]");
-        return os;
     }
 
     size_t Item::Hash::operator()(const Item& item) const {
         size_t hash = std::hash<const Production*>{}(item.prod);
-        hash = pareas::hash_combine(hash, std::hash<size_t>{}(item.dot));
+        hash = pareas::hash_combine(hash, std::hash<uint32_t>{}(item.dot));
         hash = pareas::hash_combine(hash, Terminal::Hash{}(item.lookahead));
         hash = pareas::hash_combine(hash, Terminal::Hash{}(item.lookback));
-        hash = pareas::hash_combine(hash, hash_range(item.gamma.begin(), item.gamma.end(), Symbol::Hash{}));
+        hash = pareas::hash_combine(hash, std::hash<GammaId>{}(item.gamma));
         return hash;
     }
 }
@@ -1,30 +1,47 @@
 #include "pareas/lpg/parser/llp/item_set.hpp"
-#include "pareas/lpg/hash_util.hpp"
 
 #include <fmt/ostream.h>
 
+#include <unordered_set>
+#include <algorithm>
+
 namespace pareas::parser::llp {
-    std::unordered_set<Symbol, Symbol::Hash> ItemSet::syms_before_dots() const {
-        auto syms = std::unordered_set<Symbol, Symbol::Hash>();
+    void ItemSet::canonicalize(std::vector<Item>& items) {
+        std::sort(items.begin(), items.end());
+        items.erase(std::unique(items.begin(), items.end()), items.end());
+    }
+
+    std::vector<Symbol> ItemSet::syms_before_dots() const {
+        auto syms = std::vector<Symbol>();
+        auto seen = std::unordered_set<Symbol, Symbol::Hash>();
         for (const auto& item : this->items) {
-            if (!item.is_dot_at_begin())
-                syms.insert(item.sym_before_dot());
+            if (item.is_dot_at_begin())
+                continue;
+
+            auto sym = item.sym_before_dot();
+            if (seen.insert(sym).second)
+                syms.push_back(sym);
         }
 
         return syms;
     }
 
-    std::unordered_set<Symbol, Symbol::Hash> ItemSet::syms_after_dots() const {
-        auto syms = std::unordered_set<Symbol, Symbol::Hash>();
+    std::vector<Symbol> ItemSet::syms_after_dots() const {
+        auto syms = std::vector<Symbol>();
+        auto seen = std::unordered_set<Symbol, Symbol::Hash>();
         for (const auto& item : this->items) {
-            if (!item.is_dot_at_end())
-                syms.insert(item.sym_after_dot());
+            if (item.is_dot_at_end())
+                continue;
+
+            auto sym = item.sym_after_dot();
+            if (seen.insert(sym).second)
+                syms.push_back(sym);
         }
 
         return syms;
     }
 
-    void ItemSet::dump(std::ostream& os) const {
+    void ItemSet::dump(std::ostream& os, const GammaArena& gammas) const {
         fmt::print(os, "{{ ");
         bool first = true;
         for (const auto& item : this->items) {
@@ -32,17 +49,8 @@ namespace pareas::parser::llp {
                 first = false;
             else
                 fmt::print(os, "\n  ");
-            fmt::print(os, "{}", item);
+            dump_item(os, item, gammas);
         }
         fmt::print(os, " }}\n");
     }
-
-    bool operator==(const ItemSet& lhs, const ItemSet& rhs) {
-        return lhs.items == rhs.items;
-    }
-
-    size_t ItemSet::Hash::operator()(const ItemSet& item_set) const {
-        // Need to make sure that the order doesn't matter for this hash.
-        return hash_order_independent_range(item_set.items.begin(), item_set.items.end(), Item::Hash{});
-    }
 }
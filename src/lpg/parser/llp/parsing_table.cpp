@@ -3,9 +3,98 @@
 #include <fmt/ostream.h>
 
 #include <unordered_set>
+#include <optional>
 #include <ostream>
 
+namespace {
+    using namespace pareas;
+    using namespace pareas::parser;
+
+    void write_terminal(CacheWriter& w, const Terminal& t) {
+        w.write_u8(static_cast<uint8_t>(t.type));
+        if (t.type == Terminal::Type::USER_DEFINED)
+            w.write_string(t.name());
+    }
+
+    // The cache entry was generated from the same grammar source, so every symbol in it is already interned.
+    template <typename T>
+    T expect_symbol(std::optional<T> sym) {
+        if (!sym.has_value())
+            throw CacheError("Unknown symbol in cache entry");
+        return sym.value();
+    }
+
+    Terminal read_terminal(CacheReader& r, const SymbolTable& symbols) {
+        switch (static_cast<Terminal::Type>(r.read_u8())) {
+            case Terminal::Type::USER_DEFINED: return expect_symbol(symbols.find_terminal(r.read_string()));
+            case Terminal::Type::EMPTY: return Terminal::EMPTY;
+            case Terminal::Type::START_OF_INPUT: return Terminal::START_OF_INPUT;
+            case Terminal::Type::END_OF_INPUT: return Terminal::END_OF_INPUT;
+        }
+
+        throw CacheError("Invalid terminal in cache entry");
+    }
+
+    void write_symbols(CacheWriter& w, const std::vector<Symbol>& syms) {
+        w.write_u32(syms.size());
+        for (const auto& sym : syms) {
+            w.write_u8(sym.is_terminal());
+            if (sym.is_terminal())
+                write_terminal(w, sym.as_terminal());
+            else
+                w.write_string(sym.name());
+        }
+    }
+
+    std::vector<Symbol> read_symbols(CacheReader& r, const SymbolTable& symbols) {
+        auto syms = std::vector<Symbol>();
+        size_t n = r.read_u32();
+        for (size_t i = 0; i < n; ++i) {
+            if (r.read_u8())
+                syms.push_back(read_terminal(r, symbols));
+            else
+                syms.push_back(expect_symbol(symbols.find_non_terminal(r.read_string())));
+        }
+        return syms;
+    }
+}
+
 namespace pareas::parser::llp {
+    void ParsingTable::save(CacheWriter& w, const Grammar& g) const {
+        w.write_u32(this->table.size());
+        for (const auto& [ap, entry] : this->table) {
+            write_terminal(w, ap.x);
+            write_terminal(w, ap.y);
+            write_symbols(w, entry.initial_stack);
+            write_symbols(w, entry.final_stack);
+
+            w.write_u32(entry.productions.size());
+            for (const auto* prod : entry.productions)
+                w.write_u32(g.production_id(prod));
+        }
+    }
+
+    ParsingTable ParsingTable::load(CacheReader& r, const Grammar& g) {
+        auto pt = ParsingTable();
+
+        size_t n = r.read_u32();
+        pt.table.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            auto x = read_terminal(r, *g.symbols);
+            auto y = read_terminal(r, *g.symbols);
+
+            auto entry = Entry{read_symbols(r, *g.symbols), read_symbols(r, *g.symbols), {}};
+
+            size_t num_productions = r.read_u32();
+            for (size_t j = 0; j < num_productions; ++j)
+                entry.productions.push_back(&g.productions[r.read_index(g.productions.size())]);
+
+            pt.table.insert({{x, y}, std::move(entry)});
+        }
+
+        return pt;
+    }
+
     void ParsingTable::dump_csv(std::ostream& os) {
         // Print stacks in reverse to keep it the same as in the paper
         auto dump_syms_rev = [&](const auto& syms) {
@@ -16,7 +105,7 @@ namespace pareas::parser::llp {
                     first = false;
                 else
                     fmt::print(os, " ");
-                fmt::print(os, "{}", it->name);
+                fmt::print(os, "{}", it->name());
             }
             fmt::print(os, "}}");
         };
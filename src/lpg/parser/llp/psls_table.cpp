@@ -15,7 +15,7 @@ namespace pareas::parser::llp {
                     first = false;
                 else
                     fmt::print(os, " ");
-                fmt::print(os, "{}", sym.name);
+                fmt::print(os, "{}", sym.name());
             }
 
             fmt::print(os, "\"");
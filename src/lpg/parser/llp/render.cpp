@@ -17,103 +17,139 @@ namespace {
     using namespace pareas::parser;
     using namespace pareas::parser::llp;
 
-    struct String {
-        int32_t offset;
-        int32_t size;
-    };
-
-    struct StrTab {
-        size_t item_bytes;
-        std::vector<uint64_t> superstring;
-        std::unordered_map<AdmissiblePair, String, AdmissiblePair::Hash> strings;
+    using TableEntry = std::pair<const AdmissiblePair, ParsingTable::Entry>;
+
+    // Return the entries of the parsing table ordered by the token IDs of their admissible pair. The tables
+    // are laid out in this order, rather than in the iteration order of the hash map, so that the output
+    // does not depend on how the parsing table was constructed.
+    std::vector<const TableEntry*> sorted_entries(const TokenMapping& tm, const ParsingTable& pt) {
+        auto entries = std::vector<std::pair<std::pair<size_t, size_t>, const TableEntry*>>();
+        entries.reserve(pt.table.size());
+        for (const auto& entry : pt.table) {
+            auto i = tm.token_id(entry.first.x.as_token());
+            auto j = tm.token_id(entry.first.y.as_token());
+            entries.push_back({{i, j}, &entry});
+        }
 
-        template <typename F>
-        StrTab(const ParsingTable& pt, size_t item_bytes, F get_string);
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
 
-        void render(Renderer* r, const TokenMapping* tm, std::string_view name, std::string_view type);
-    };
+        auto result = std::vector<const TableEntry*>();
+        result.reserve(entries.size());
+        for (const auto& [key, entry] : entries)
+            result.push_back(entry);
+        return result;
+    }
 
     template <typename F>
-    StrTab::StrTab(const ParsingTable& pt, size_t item_bytes, F get_string):
-        item_bytes(item_bytes) {
+    ParserTables::StrTab build_strtab(
+        const TokenMapping& tm,
+        const std::vector<const TableEntry*>& entries,
+        size_t item_bytes,
+        F get_string
+    ) {
+        size_t n = tm.num_tokens();
+        auto strtab = ParserTables::StrTab{
+            .item_bytes = item_bytes,
+            .superstring = {},
+            .offsets = std::vector<int32_t>(n * n, -1),
+            .lengths = std::vector<int32_t>(n * n, -1),
+        };
+
         // Simple implementation for now
-        int32_t offset = 0;
-        for (const auto& [ap, entry] : pt.table) {
+        for (const auto* table_entry : entries) {
+            const auto& [ap, entry] = *table_entry;
             auto string = get_string(entry);
-            this->superstring.insert(superstring.end(), string.begin(), string.end());
-            this->strings[ap] = {offset, static_cast<int32_t>(string.size())};
-            offset += string.size();
+            auto i = tm.token_id(ap.x.as_token());
+            auto j = tm.token_id(ap.y.as_token());
+            strtab.offsets[i * n + j] = static_cast<int32_t>(strtab.superstring.size());
+            strtab.lengths[i * n + j] = static_cast<int32_t>(string.size());
+            strtab.superstring.insert(strtab.superstring.end(), string.begin(), string.end());
         }
-    }
 
-    void StrTab::render(Renderer* r, const TokenMapping* tm, std::string_view name, std::string_view type) {
-        size_t n = tm->num_tokens();
-        auto stringrefs = std::vector<std::vector<String>>(
-            n,
-            std::vector<String>(n, {-1, -1})
-        );
+        return strtab;
+    }
+}
 
-        for (const auto& [ap, string] : this->strings) {
-            auto i = tm->token_id(ap.x.as_token());
-            auto j = tm->token_id(ap.y.as_token());
-            stringrefs[i][j] = string;
+namespace pareas::parser::llp {
+    ParserTables::ParserTables(const TokenMapping& tm, const Grammar& g, const ParsingTable& pt):
+        num_productions(g.productions.size()),
+        production_bits(g.production_backing_type_bits()) {
+        auto entries = sorted_entries(tm, pt);
+
+        auto symbol_mapping = std::unordered_map<Symbol, uint64_t, Symbol::Hash>();
+        for (const auto* table_entry : entries) {
+            const auto& entry = table_entry->second;
+            for (const auto& sym : entry.initial_stack)
+                symbol_mapping.insert({sym, symbol_mapping.size()});
+            for (const auto& sym : entry.final_stack)
+                symbol_mapping.insert({sym, symbol_mapping.size()});
         }
 
-        r->align_data(this->item_bytes);
-        auto table_offset = r->data_offset();
+        this->bracket_bits = pareas::int_bit_width(2 * symbol_mapping.size());
+
+        auto bracket_id = [&](const Symbol& sym, bool left) {
+            auto id = symbol_mapping.at(sym);
 
-        for (auto value : this->superstring) {
-            r->write_data_int(value, this->item_bytes);
+            // Left brackets get odd ID's, right brackets get even ID's.
+            // This way, we can perform a simple subtract and reduce by bit and to
+            // check if all the brackets match up.
+            return left ? id * 2 + 1 : id * 2;
+        };
+
+        // Production id's are assigned according to their index in the
+        // productions vector, so we can just store them in order of definition.
+        this->arities.reserve(this->num_productions);
+        for (const auto& prod : g.productions) {
+            this->arities.push_back(prod.arity());
         }
 
-        r->align_data(sizeof(int32_t));
-        auto offsets_offset = r->data_offset();
+        if (!g.operator_lists.empty()) {
+            this->operator_list_roles.reserve(this->num_productions);
+            this->left_assoc_lists.reserve(this->num_productions);
+            for (const auto& prod : g.productions) {
+                this->operator_list_roles.push_back(static_cast<int32_t>(g.operator_list_role(&prod)));
 
-        for (const auto& v : stringrefs) {
-            for (auto str : v) {
-                // According to cppreference, this cast is valid and will produce the desired result.
-                r->write_data_int(static_cast<uint32_t>(str.offset), sizeof(uint32_t));
+                const auto* list = g.operator_list(&prod);
+                bool left_assoc = list && list->assoc == OperatorList::Associativity::LEFT;
+                this->left_assoc_lists.push_back(left_assoc ? static_cast<int32_t>(list - g.operator_lists.data() + 1) : 0);
             }
         }
 
-        auto lengths_offset = r->data_offset();
+        this->stack_change_table = build_strtab(
+            tm,
+            entries,
+            this->bracket_bits / 8,
+            [&](const ParsingTable::Entry& entry) {
+                auto result = std::vector<uint64_t>();
 
-        for (const auto& v : stringrefs) {
-            for (auto str : v) {
-                r->write_data_int(static_cast<uint32_t>(str.size), sizeof(uint32_t));
+                for (auto it = entry.initial_stack.rbegin(); it != entry.initial_stack.rend(); ++it) {
+                    result.push_back(bracket_id(*it, false));
+                }
+
+                for (auto it = entry.final_stack.begin(); it != entry.final_stack.end(); ++it) {
+                    result.push_back(bracket_id(*it, true));
+                }
+
+                return result;
             }
-        }
+        );
 
-        fmt::print(r->hpp, "extern const StrTab<{}> {};\n", type, name);
+        this->parse_table = build_strtab(
+            tm,
+            entries,
+            this->production_bits / 8,
+            [&](const ParsingTable::Entry& entry) {
+                auto result = std::vector<uint64_t>();
 
-        fmt::print(
-            r->cpp,
-            "const StrTab<{}> {}= {{\n"
-            "    .n = {},\n"
-            "    .table = {},\n"
-            "    .offsets = {},\n"
-            "    .lengths = {},\n"
-            "}};\n",
-            type,
-            name,
-            this->superstring.size(),
-            r->render_offset_cast(table_offset, type),
-            r->render_offset_cast(offsets_offset, "int32_t"),
-            r->render_offset_cast(lengths_offset, "int32_t")
+                for (const auto* prod : entry.productions)
+                    result.push_back(g.production_id(prod));
+                return result;
+            }
         );
     }
-}
 
-namespace pareas::parser::llp {
     ParserRenderer::ParserRenderer(Renderer* r, const TokenMapping* tm, const Grammar* g, const ParsingTable* pt):
-        r(r), tm(tm), g(g), pt(pt) {
-
-        for (const auto& [ap, entry] : this->pt->table) {
-            for (const auto& sym : entry.initial_stack)
-                this->symbol_mapping.insert({sym, this->symbol_mapping.size()});
-            for (const auto& sym : entry.final_stack)
-                this->symbol_mapping.insert({sym, this->symbol_mapping.size()});
-        }
+        r(r), g(g), tables(*tm, *g, *pt) {
     }
 
     void ParserRenderer::render() const {
@@ -127,31 +163,20 @@ namespace pareas::parser::llp {
             "    const T* table; // n\n"
             "    const int32_t* offsets; // NUM_TOKENS\n"
             "    const int32_t* lengths; // NUM_TOKENS\n"
-            "}};\n",
-            this->bracket_backing_bits()
+            "}};\n"
         );
 
         this->render_production_arity_data();
+        // Grammars without operator lists don't need to be restructured, so don't emit tables for them.
+        if (!this->g->operator_lists.empty())
+            this->render_operator_list_data();
         this->render_stack_change_table();
         this->render_parse_table();
     }
 
-    uint64_t ParserRenderer::bracket_id(const Symbol& sym, bool left) const {
-        auto id = this->symbol_mapping.at(sym);
-
-        // Left brackets get odd ID's, right brackets get even ID's.
-        // This way, we can perform a simple subtract and reduce by bit and to
-        // check if all the brackets match up.
-        return left ? id * 2 + 1 : id * 2;
-    }
-
-    size_t ParserRenderer::bracket_backing_bits() const {
-        return pareas::int_bit_width(2 * this->symbol_mapping.size());
-    }
-
     void ParserRenderer::render_productions() const {
-        auto n = this->g->productions.size();
-        auto backing_bits = this->g->production_backing_type_bits();
+        auto n = this->tables.num_productions;
+        auto backing_bits = this->tables.production_bits;
 
         fmt::print(this->r->fut, "module production = u{}\n", backing_bits);
 
@@ -193,56 +218,87 @@ namespace pareas::parser::llp {
 
         fmt::print(this->r->cpp, "const int32_t* arities = {};\n", this->r->render_offset_cast(offset, "int32_t"));
 
-        // Production id's are assigned according to their index in the
-        // productions vector, so we can just write them in order of definition.
-        for (const auto& prod : this->g->productions) {
-            this->r->write_data_int(prod.arity(), sizeof(uint32_t));
+        for (auto arity : this->tables.arities) {
+            this->r->write_data_int(static_cast<uint32_t>(arity), sizeof(uint32_t));
         }
     }
 
-    void ParserRenderer::render_stack_change_table() const {
-        size_t bracket_bits = this->bracket_backing_bits();
+    void ParserRenderer::render_operator_list_data() const {
+        auto render_array = [&](const std::vector<int32_t>& values, std::string_view name) {
+            this->r->align_data(sizeof(uint32_t));
+            auto offset = this->r->data_offset();
 
-        auto strtab = StrTab(
-            *this->pt,
-            bracket_bits / 8,
-            [&](const ParsingTable::Entry& entry) {
-                auto result = std::vector<uint64_t>();
+            fmt::print(this->r->hpp, "extern const int32_t* {}; // NUM_PRODUCTIONS\n", name);
 
-                for (auto it = entry.initial_stack.rbegin(); it != entry.initial_stack.rend(); ++it) {
-                    result.push_back(this->bracket_id(*it, false));
-                }
+            fmt::print(this->r->cpp, "const int32_t* {} = {};\n", name, this->r->render_offset_cast(offset, "int32_t"));
 
-                for (auto it = entry.final_stack.begin(); it != entry.final_stack.end(); ++it) {
-                    result.push_back(this->bracket_id(*it, true));
-                }
+            // The tables are small, and the Futhark passes that restructure expressions need them at compile time.
+            fmt::print(this->r->fut, "let {} = [", name);
 
-                return result;
+            for (size_t i = 0; i < values.size(); ++i) {
+                this->r->write_data_int(static_cast<uint32_t>(values[i]), sizeof(uint32_t));
+                fmt::print(this->r->fut, "{}{}", i == 0 ? "" : ", ", values[i]);
             }
-        );
+
+            fmt::print(this->r->fut, "] :> [num_productions]i32\n");
+        };
+
+        render_array(this->tables.operator_list_roles, "operator_list_roles");
+        render_array(this->tables.left_assoc_lists, "left_assoc_lists");
+    }
+
+    void ParserRenderer::render_stack_change_table() const {
+        size_t bracket_bits = this->tables.bracket_bits;
 
         fmt::print(this->r->hpp, "using Bracket = uint{}_t;\n", bracket_bits);
 
         fmt::print(this->r->fut, "module bracket = u{}\n", bracket_bits);
 
-        strtab.render(this->r, this->tm, "stack_change_table", "Bracket");
+        this->render_strtab(this->tables.stack_change_table, "stack_change_table", "Bracket");
     }
 
     void ParserRenderer::render_parse_table() const {
-        size_t backing_bits = this->g->production_backing_type_bits();
+        this->render_strtab(this->tables.parse_table, "parse_table", "Production");
+    }
 
-        auto strtab = StrTab(
-            *this->pt,
-            backing_bits / 8,
-            [&](const ParsingTable::Entry& entry) {
-                auto result = std::vector<uint64_t>();
+    void ParserRenderer::render_strtab(const ParserTables::StrTab& strtab, std::string_view name, std::string_view type) const {
+        this->r->align_data(strtab.item_bytes);
+        auto table_offset = this->r->data_offset();
 
-                for (const auto* prod : entry.productions)
-                    result.push_back(this->g->production_id(prod));
-                return result;
-            }
-        );
+        for (auto value : strtab.superstring) {
+            this->r->write_data_int(value, strtab.item_bytes);
+        }
+
+        this->r->align_data(sizeof(int32_t));
+        auto offsets_offset = this->r->data_offset();
+
+        for (auto offset : strtab.offsets) {
+            // According to cppreference, this cast is valid and will produce the desired result.
+            this->r->write_data_int(static_cast<uint32_t>(offset), sizeof(uint32_t));
+        }
+
+        auto lengths_offset = this->r->data_offset();
+
+        for (auto length : strtab.lengths) {
+            this->r->write_data_int(static_cast<uint32_t>(length), sizeof(uint32_t));
+        }
 
-        strtab.render(this->r, this->tm, "parse_table", "Production");
+        fmt::print(this->r->hpp, "extern const StrTab<{}> {};\n", type, name);
+
+        fmt::print(
+            this->r->cpp,
+            "const StrTab<{}> {}= {{\n"
+            "    .n = {},\n"
+            "    .table = {},\n"
+            "    .offsets = {},\n"
+            "    .lengths = {},\n"
+            "}};\n",
+            type,
+            name,
+            strtab.superstring.size(),
+            this->r->render_offset_cast(table_offset, type),
+            this->r->render_offset_cast(offsets_offset, "int32_t"),
+            this->r->render_offset_cast(lengths_offset, "int32_t")
+        );
     }
 }
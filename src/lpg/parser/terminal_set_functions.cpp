@@ -2,42 +2,169 @@
 
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <deque>
+#include <bit>
 #include <cassert>
 
 namespace pareas::parser {
-    bool merge_terminal_sets_omit_empty(TerminalSet& dst, const TerminalSet& src) {
-        bool changed = false;
-        for (const auto& t : src) {
-            if (t.is_empty())
-                continue;
-            changed |= dst.insert(t).second;
+    TerminalSet::Iterator::Iterator(const TerminalSet* set, size_t id): set(set), id(id) {
+        this->skip_to_next();
+    }
+
+    Terminal TerminalSet::Iterator::operator*() const {
+        return this->set->symbols->terminal(this->id);
+    }
+
+    TerminalSet::Iterator& TerminalSet::Iterator::operator++() {
+        ++this->id;
+        this->skip_to_next();
+        return *this;
+    }
+
+    TerminalSet::Iterator TerminalSet::Iterator::operator++(int) {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    bool TerminalSet::Iterator::operator==(const Iterator& other) const {
+        return this->set == other.set && this->id == other.id;
+    }
+
+    void TerminalSet::Iterator::skip_to_next() {
+        const auto& words = this->set->words;
+        size_t end = words.size() * WORD_BITS;
+        while (this->id < end) {
+            size_t word = this->id / WORD_BITS;
+            size_t bit = this->id % WORD_BITS;
+            auto remaining = words[word] >> bit;
+            if (remaining != 0) {
+                this->id += std::countr_zero(remaining);
+                return;
+            }
+
+            this->id = (word + 1) * WORD_BITS;
+        }
+
+        this->id = end;
+    }
+
+    TerminalSet::TerminalSet(const SymbolTable* symbols):
+        symbols(symbols), words((symbols->num_terminals() + WORD_BITS - 1) / WORD_BITS, 0) {}
+
+    bool TerminalSet::insert(const Terminal& t) {
+        size_t word = t.id / WORD_BITS;
+        if (word >= this->words.size())
+            this->words.resize(word + 1, 0);
+
+        auto mask = Word{1} << (t.id % WORD_BITS);
+        bool inserted = (this->words[word] & mask) == 0;
+        this->words[word] |= mask;
+        return inserted;
+    }
+
+    bool TerminalSet::erase(const Terminal& t) {
+        if (!this->contains(t))
+            return false;
+
+        this->words[t.id / WORD_BITS] &= ~(Word{1} << (t.id % WORD_BITS));
+        return true;
+    }
+
+    bool TerminalSet::contains(const Terminal& t) const {
+        size_t word = t.id / WORD_BITS;
+        return word < this->words.size() && ((this->words[word] >> (t.id % WORD_BITS)) & 1) != 0;
+    }
+
+    bool TerminalSet::merge(const TerminalSet& other, bool omit_empty) {
+        if (other.words.size() > this->words.size())
+            this->words.resize(other.words.size(), 0);
+
+        Word changed = 0;
+        for (size_t i = 0; i < other.words.size(); ++i) {
+            auto src = other.words[i];
+            if (i == Terminal::EMPTY.id / WORD_BITS && omit_empty)
+                src &= ~(Word{1} << (Terminal::EMPTY.id % WORD_BITS));
+
+            changed |= src & ~this->words[i];
+            this->words[i] |= src;
+        }
+
+        return changed != 0;
+    }
+
+    bool TerminalSet::empty() const {
+        return std::all_of(this->words.begin(), this->words.end(), [](Word w) { return w == 0; });
+    }
+
+    size_t TerminalSet::size() const {
+        size_t n = 0;
+        for (auto w : this->words)
+            n += std::popcount(w);
+        return n;
+    }
+
+    TerminalSet::Iterator TerminalSet::begin() const {
+        return Iterator(this, 0);
+    }
+
+    TerminalSet::Iterator TerminalSet::end() const {
+        return Iterator(this, this->words.size() * WORD_BITS);
+    }
+
+    bool TerminalSet::operator==(const TerminalSet& other) const {
+        // Sets may be of different sizes, in which case the missing words are zero.
+        size_t n = std::max(this->words.size(), other.words.size());
+        for (size_t i = 0; i < n; ++i) {
+            auto a = i < this->words.size() ? this->words[i] : 0;
+            auto b = i < other.words.size() ? other.words[i] : 0;
+            if (a != b)
+                return false;
         }
 
-        return changed;
+        return true;
     }
 
-    TerminalSetFunctions::TerminalSetFunctions(const Grammar& g) {
-        this->base_first_sets = this->compute_base_first_or_last_set(g, true);
-        this->base_last_sets = this->compute_base_first_or_last_set(g, false);
+    bool merge_terminal_sets_omit_empty(TerminalSet& dst, const TerminalSet& src) {
+        return dst.merge(src, true);
+    }
+
+    TerminalSetFunctions::TerminalSetFunctions(const Grammar& g): g(&g) {
+        this->base_first_sets = this->compute_base_first_or_last_set(true);
+        this->base_last_sets = this->compute_base_first_or_last_set(false);
+
+        this->suffix_first_sets = this->compute_affix_sets(true);
+        this->prefix_last_sets = this->compute_affix_sets(false);
 
-        this->follow_sets = this->compute_follow_or_before_sets(g, true);
-        this->before_sets = this->compute_follow_or_before_sets(g, false);
+        this->follow_sets = this->compute_follow_or_before_sets(true);
+        this->before_sets = this->compute_follow_or_before_sets(false);
     }
 
     const TerminalSet& TerminalSetFunctions::first(const NonTerminal& nt) const {
-        return this->base_first_sets.at(nt);
+        return this->base_first_sets.at(nt.id);
     }
 
     const TerminalSet& TerminalSetFunctions::last(const NonTerminal& nt) const {
-        return this->base_last_sets.at(nt);
+        return this->base_last_sets.at(nt.id);
     }
 
     const TerminalSet& TerminalSetFunctions::follow(const NonTerminal& nt) const {
-        return this->follow_sets.at(nt);
+        return this->follow_sets.at(nt.id);
     }
 
     const TerminalSet& TerminalSetFunctions::before(const NonTerminal& nt) const {
-        return this->before_sets.at(nt);
+        return this->before_sets.at(nt.id);
+    }
+
+    const TerminalSet& TerminalSetFunctions::first_of_suffix(const Production& prod, size_t offset) const {
+        assert(offset <= prod.rhs.size());
+        return this->suffix_first_sets[this->g->production_id(&prod)][offset];
+    }
+
+    const TerminalSet& TerminalSetFunctions::last_of_prefix(const Production& prod, size_t len) const {
+        assert(len <= prod.rhs.size());
+        return this->prefix_last_sets[this->g->production_id(&prod)][len];
     }
 
     TerminalSet TerminalSetFunctions::compute_first(std::span<const Symbol> symbols) const {
@@ -50,9 +177,9 @@ namespace pareas::parser {
 
     void TerminalSetFunctions::dump(std::ostream& os) {
         auto dump_nt_ts = [&](const auto& sets){
-            for (auto [nt, set] : sets) {
-                fmt::print(os, "    {}:\t", nt);
-                for (const auto& t : set) {
+            for (size_t i = 0; i < sets.size(); ++i) {
+                fmt::print(os, "    {}:\t", this->g->symbols->non_terminal(static_cast<SymbolId>(i)));
+                for (const auto& t : sets[i]) {
                     fmt::print(os, " {}", t);
                 }
                 fmt::print(os, "\n");
@@ -72,10 +199,26 @@ namespace pareas::parser {
         dump_nt_ts(this->before_sets);
     }
 
-    TerminalSetMap TerminalSetFunctions::compute_base_first_or_last_set(const Grammar& g, bool first) const {
-        auto sets = TerminalSetMap();
+    std::vector<TerminalSet> TerminalSetFunctions::compute_base_first_or_last_set(bool first) const {
+        const auto& prods = this->g->productions;
+        size_t num_non_terminals = this->g->symbols->num_non_terminals();
+        auto sets = std::vector<TerminalSet>(num_non_terminals, TerminalSet(this->g->symbols.get()));
+
+        // For every non-terminal, the productions which have it in their right hand side. These need to be
+        // revisited when the set of that non-terminal changes.
+        auto dependents = std::vector<std::vector<size_t>>(num_non_terminals);
+        for (size_t i = 0; i < prods.size(); ++i) {
+            for (const auto& sym : prods[i].rhs) {
+                if (sym.is_terminal())
+                    continue;
+                auto& deps = dependents[sym.id];
+                if (deps.empty() || deps.back() != i)
+                    deps.push_back(i);
+            }
+        }
 
         auto add_prod = [&](const Production& prod) {
+            auto& dst_set = sets[prod.lhs.id];
             bool changed = false;
 
             for (size_t i = 0; i < prod.rhs.size(); ++i) {
@@ -84,81 +227,117 @@ namespace pareas::parser {
                 if (sym.is_empty_terminal()) {
                     continue;
                 } else if (sym.is_terminal()) {
-                    changed |= sets[prod.lhs].insert(sym.as_terminal()).second;
+                    changed |= dst_set.insert(sym.as_terminal());
                     return changed;
                 } else {
-                    auto dst_set = sets[prod.lhs]; // be lazy and copy for now
-                    const auto& sym_set = sets[sym.as_non_terminal()];
-                    bool sym_set_has_empty = sym_set.contains(Terminal::EMPTY);
-
+                    // Note: if sym is prod.lhs, this merges the set with itself, which is fine.
+                    const auto& sym_set = sets[sym.id];
                     changed |= merge_terminal_sets_omit_empty(dst_set, sym_set);
-                    sets[prod.lhs] = dst_set;
 
-                    if (!sym_set_has_empty)
+                    if (!sym_set.contains(Terminal::EMPTY))
                         return changed;
                 }
             }
 
-            changed |= sets[prod.lhs].insert(Terminal::EMPTY).second;
+            changed |= dst_set.insert(Terminal::EMPTY);
             return changed;
         };
 
-        bool changed = true;
-        while (changed) {
-            changed = false;
-            for (const auto& prod : g.productions) {
-                changed |= add_prod(prod);
+        auto queue = std::deque<size_t>();
+        auto queued = std::vector<bool>(prods.size(), true);
+        for (size_t i = 0; i < prods.size(); ++i)
+            queue.push_back(i);
+
+        while (!queue.empty()) {
+            auto i = queue.front();
+            queue.pop_front();
+            queued[i] = false;
+
+            if (!add_prod(prods[i]))
+                continue;
+
+            for (auto dep : dependents[prods[i].lhs.id]) {
+                if (!queued[dep]) {
+                    queued[dep] = true;
+                    queue.push_back(dep);
+                }
             }
         }
 
         return sets;
     }
 
-    TerminalSetMap TerminalSetFunctions::compute_follow_or_before_sets(const Grammar& g, bool follow) const {
-        auto sets = TerminalSetMap();
+    std::vector<std::vector<TerminalSet>> TerminalSetFunctions::compute_affix_sets(bool first) const {
+        auto result = std::vector<std::vector<TerminalSet>>();
+        result.reserve(this->g->productions.size());
 
-        // Pre-insert left-hand sides: this will both make sure that a key is allocated
-        // (allowing us to omit a copy), and will make sure that any LHS with empty follow/
-        // before set is present
-        for (const auto& prod : g.productions) {
-            sets.insert({prod.lhs, {}});
+        for (const auto& prod : this->g->productions) {
+            size_t n = prod.rhs.size();
+            auto& sets = result.emplace_back(n + 1, TerminalSet(this->g->symbols.get()));
+
+            // Extend the affix by a single symbol at a time, starting from the empty suffix at offset n
+            // or the empty prefix of length 0.
+            sets[first ? n : 0].insert(Terminal::EMPTY);
+            for (size_t k = 0; k < n; ++k) {
+                size_t src = first ? n - k : k;
+                size_t dst = first ? n - k - 1 : k + 1;
+                const auto& sym = prod.rhs[first ? dst : src];
+
+                if (sym.is_empty_terminal()) {
+                    sets[dst] = sets[src];
+                } else if (sym.is_terminal()) {
+                    sets[dst].insert(sym.as_terminal());
+                } else {
+                    const auto& ts = first ? this->first(sym.as_non_terminal()) : this->last(sym.as_non_terminal());
+                    merge_terminal_sets_omit_empty(sets[dst], ts);
+                    if (ts.contains(Terminal::EMPTY))
+                        sets[dst].merge(sets[src]);
+                }
+            }
         }
 
-        auto add_prod = [&](const Production& prod) {
-            bool changed = false;
+        return result;
+    }
 
+    std::vector<TerminalSet> TerminalSetFunctions::compute_follow_or_before_sets(bool follow) const {
+        const auto& prods = this->g->productions;
+        size_t num_non_terminals = this->g->symbols->num_non_terminals();
+        auto sets = std::vector<TerminalSet>(num_non_terminals, TerminalSet(this->g->symbols.get()));
+
+        // The follow (before) set of a non-terminal consists of the first (last) set of what comes after
+        // (before) it in a production, and if that may be empty, the follow (before) set of the left hand
+        // side of that production. The former does not change, so it is added once, and the latter is
+        // propagated along the edges from left hand side to non-terminal until nothing changes.
+        auto successors = std::vector<std::vector<SymbolId>>(num_non_terminals);
+
+        for (const auto& prod : prods) {
             for (size_t i = 0; i < prod.rhs.size(); ++i) {
                 const auto& sym = prod.rhs[i];
                 if (sym.is_terminal())
                     continue;
-                auto nt = sym.as_non_terminal();
-
-                auto b = follow ?
-                    std::span(prod.rhs).subspan(i + 1) :
-                    std::span(prod.rhs).subspan(0, i);
-
-                auto ts = this->compute_first_or_last_set(b, follow);
-                // Should be pre-inserted. If not, there is no production which has this
-                // symbol as LHS.
-                auto set = sets.at(nt);
-
-                changed = merge_terminal_sets_omit_empty(set, ts);
-                if (ts.contains(Terminal::EMPTY)) {
-                    changed |= merge_terminal_sets_omit_empty(set, sets[prod.lhs]);
-                }
 
-                sets[nt] = set;
+                const auto& ts = follow ? this->first_of_suffix(prod, i + 1) : this->last_of_prefix(prod, i);
+                merge_terminal_sets_omit_empty(sets[sym.id], ts);
+                if (ts.contains(Terminal::EMPTY) && sym.id != prod.lhs.id)
+                    successors[prod.lhs.id].push_back(sym.id);
             }
+        }
 
-            return changed;
-        };
+        auto queue = std::deque<SymbolId>();
+        auto queued = std::vector<bool>(sets.size(), true);
+        for (size_t i = 0; i < sets.size(); ++i)
+            queue.push_back(static_cast<SymbolId>(i));
 
-        bool changed = true;
-        while (changed) {
-            changed = false;
+        while (!queue.empty()) {
+            auto nt = queue.front();
+            queue.pop_front();
+            queued[nt] = false;
 
-            for (const auto& prod : g.productions) {
-                changed |= add_prod(prod);
+            for (auto succ : successors[nt]) {
+                if (merge_terminal_sets_omit_empty(sets[succ], sets[nt]) && !queued[succ]) {
+                    queued[succ] = true;
+                    queue.push_back(succ);
+                }
             }
         }
 
@@ -166,7 +345,7 @@ namespace pareas::parser {
     }
 
     TerminalSet TerminalSetFunctions::compute_first_or_last_set(std::span<const Symbol> symbols, bool first) const {
-        auto set = TerminalSet();
+        auto set = TerminalSet(this->g->symbols.get());
         const auto& base_sets = first ? this->base_first_sets : this->base_last_sets;
 
         for (size_t i = 0; i < symbols.size(); ++i) {
@@ -178,8 +357,7 @@ namespace pareas::parser {
                 return set;
             }
 
-            auto nt = sym.as_non_terminal();
-            const auto& ts = base_sets.at(nt);
+            const auto& ts = base_sets.at(sym.id);
             merge_terminal_sets_omit_empty(set, ts);
 
             if (!ts.contains(Terminal::EMPTY)) {
@@ -43,6 +43,13 @@ namespace pareas {
         return this->tokens.size();
     }
 
+    std::vector<const Token*> TokenMapping::ordered_tokens() const {
+        auto tokens_ordered = std::vector<const Token*>(this->num_tokens());
+        for (const auto& [token, id] : this->tokens)
+            tokens_ordered[id] = &token;
+        return tokens_ordered;
+    }
+
     void TokenMapping::render(Renderer& r) const {
         fmt::print(r.fut, "module token = u{}\n", this->backing_type_bits());
 
@@ -52,9 +59,7 @@ namespace pareas {
         fmt::print(r.cpp, "    switch (t) {{\n");
 
         // Render the tokens nice and ordered.
-        auto tokens_ordered = std::vector<const Token*>(this->num_tokens());
-        for (const auto& [token, id] : this->tokens)
-            tokens_ordered[id] = &token;
+        auto tokens_ordered = this->ordered_tokens();
 
         for (size_t id = 0; id < tokens_ordered.size(); ++id) {
             const auto& name = tokens_ordered[id]->name;
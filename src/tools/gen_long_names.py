@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# Generates programs with many long identifiers, which are used to benchmark name linking in the frontend.
+# For every name length, a program is written and optionally compiled with `pareas --check --profile <level>`,
+# after which the profile is printed. Compare the time of the "extract lexemes" step between lengths, which
+# should not grow with the length of the longest identifier.
+# With --collisions, the names are built from Thue-Morse blocks so that groups of different names have the same
+# polynomial hash modulo 2^64 for any odd multiplier, which stresses how name linking handles hash collisions.
+import argparse
+import os
+import random
+import subprocess
+import string
+import sys
+
+p = argparse.ArgumentParser(description='Generate programs with long identifiers to benchmark name linking')
+p.add_argument('--output-dir', required=True, help='Directory to write the generated programs to')
+p.add_argument('--functions', type=int, default=1000, help='Number of functions per program')
+p.add_argument('--vars', type=int, default=8, help='Number of variables per function')
+p.add_argument('--lengths', type=int, nargs='+', default=[8, 32, 200, 1000], help='Identifier lengths to generate programs for')
+p.add_argument('--single-long-name', action='store_true', help='Only make the name of a single function long, and keep all other names short')
+p.add_argument('--collisions', type=int, default=1, help='Number of different names that share a hash, rounded up to a power of two')
+p.add_argument('--seed', type=int, default=0, help='Random seed')
+p.add_argument('--pareas', help='Path to the pareas binary. If given, each program is compiled and the profile is printed')
+p.add_argument('--profile', type=int, default=2, help='Profile level to pass to pareas')
+
+args = p.parse_args()
+
+alphabet = string.ascii_letters + string.digits + '_'
+
+# The Thue-Morse sequence of length 2^k and its complement have the same polynomial hash modulo 2^64 for
+# any odd multiplier when k * (k + 1) / 2 >= 64. Replacing one such block by the other anywhere in a name
+# preserves the hash, so names made of b blocks form groups of 2^b different names with the same hash.
+collision_block_bits = 11
+collision_blocks = max(0, (args.collisions - 1).bit_length())
+thue_morse = ''.join('ab'[bin(i).count('1') % 2] for i in range(1 << collision_block_bits))
+thue_morse_complement = thue_morse.translate(str.maketrans('ab', 'ba'))
+
+def make_name(rng, length):
+    # Names must not start with a digit. Use a shared prefix so that the names only differ at the end,
+    # which is the worst case for comparing names character by character.
+    suffix = ''.join(rng.choice(alphabet) for _ in range(8))
+    return 'n' + '_' * max(0, length - 9) + suffix
+
+def make_colliding_name(index, length):
+    # Every group of names gets its own prefix of a fixed length, and the members of a group only differ in
+    # which blocks are complemented. All names of a group have the same length, and thus the same hash.
+    group, member = divmod(index, 1 << collision_blocks)
+    prefix = f'n{group:08}'
+    blocks = ''.join(thue_morse_complement if member >> i & 1 else thue_morse for i in range(collision_blocks))
+    return prefix + blocks + '_' * max(0, length - len(prefix) - len(blocks))
+
+def generate(length):
+    rng = random.Random(args.seed)
+    names = 0
+    def make(name_length):
+        nonlocal names
+        names += 1
+        if collision_blocks == 0:
+            return make_name(rng, name_length)
+        return make_colliding_name(names - 1, name_length)
+
+    lines = []
+    fn_names = []
+    for i in range(args.functions):
+        fn_length = length if not args.single_long_name or i == 0 else 8
+        var_length = length if not args.single_long_name else 8
+        fn_name = make(fn_length)
+        var_names = [make(var_length) for _ in range(args.vars)]
+
+        lines.append(f'fn {fn_name}[{var_names[0]}: int]: int {{')
+        for prev, var in zip(var_names, var_names[1:]):
+            lines.append(f'    var {var} = {prev} + {prev};')
+        if fn_names:
+            lines.append(f'    return {fn_names[-1]}[{var_names[-1]}];')
+        else:
+            lines.append(f'    return {var_names[-1]};')
+        lines.append('}')
+        fn_names.append(fn_name)
+    return '\n'.join(lines) + '\n'
+
+os.makedirs(args.output_dir, exist_ok=True)
+
+for length in args.lengths:
+    path = os.path.join(args.output_dir, f'long_names_{length}.par')
+    with open(path, 'w') as f:
+        f.write(generate(length))
+
+    if args.pareas is None:
+        print(path)
+        continue
+
+    print(f'{path}:', flush=True)
+    result = subprocess.run([args.pareas, '--check', '--profile', str(args.profile), path])
+    if result.returncode != 0:
+        sys.exit(result.returncode)
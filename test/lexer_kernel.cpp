@@ -0,0 +1,136 @@
+// Checks that the host lexer kernel computes the same states and tokens as a sequential scan over the merge table,
+// which is how src/compiler/lexer/lexer.fut defines them, for the lexers of the compiler and the JSON parser and
+// for every instruction set that is supported by this CPU. The inputs are the files given on the command line,
+// those files repeated so that they span multiple blocks of the kernel, and random bytes.
+#include "pareas/host/lexer_kernel.hpp"
+
+#include "pareas_grammar.hpp"
+#include "json_grammar.hpp"
+
+#include <fmt/format.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <span>
+#include <cstdlib>
+#include <cstdint>
+
+namespace {
+    using pareas::host::Isa;
+    using pareas::host::LexerKernel;
+
+    template <typename LexTable>
+    std::vector<typename LexTable::State> reference_scan(const LexTable& table, std::span<const uint8_t> input) {
+        using State = typename LexTable::State;
+        constexpr auto mask = LexerKernel<State>::STATE_MASK;
+
+        auto states = std::vector<State>(input.size());
+        for (size_t i = 0; i < input.size(); ++i) {
+            auto initial = table.initial_states[input[i]];
+            states[i] = i == 0 ? initial : table.merge_table[(states[i - 1] & mask) * table.n + (initial & mask)];
+        }
+
+        return states;
+    }
+
+    template <typename LexTable>
+    bool check(const char* lexer_name, const LexTable& table, const std::string& input_name, std::span<const uint8_t> input) {
+        using State = typename LexTable::State;
+        constexpr auto produces_token = LexerKernel<State>::PRODUCES_TOKEN;
+        constexpr auto mask = LexerKernel<State>::STATE_MASK;
+
+        auto expected = reference_scan(table, input);
+
+        // A token ends at the byte before a transition which produces a token, see `LexerKernel::lex`.
+        auto expected_tokens = std::vector<std::pair<size_t, size_t>>();
+        size_t start = 0;
+        for (size_t i = 0; i < input.size(); ++i) {
+            if (i + 1 == input.size() || (expected[i + 1] & produces_token)) {
+                expected_tokens.push_back({static_cast<size_t>(table.final_states[expected[i] & mask]), start});
+                start = i + 1;
+            }
+        }
+
+        bool ok = true;
+        for (auto isa : {Isa::SCALAR, Isa::AVX2, Isa::AVX512}) {
+            if (!pareas::host::isa_supported(isa))
+                continue;
+
+            auto kernel = LexerKernel<State>(table.n, table.initial_states, table.merge_table, isa);
+            auto states = std::vector<State>(input.size());
+            kernel.scan(input, states);
+
+            auto tokens = kernel.lex(input, table.final_states);
+            bool tokens_match = tokens.size() == expected_tokens.size();
+            for (size_t i = 0; tokens_match && i < tokens.size(); ++i) {
+                tokens_match = static_cast<size_t>(tokens[i].token) == expected_tokens[i].first
+                    && tokens[i].start == expected_tokens[i].second;
+            }
+
+            if (states != expected || !tokens_match) {
+                fmt::print("FAIL {} lexer, {} kernel, {} ({} bytes)\n", lexer_name, pareas::host::isa_name(isa), input_name, input.size());
+                ok = false;
+            }
+        }
+
+        return ok;
+    }
+
+    template <typename LexTable>
+    bool check_all(const char* lexer_name, const LexTable& table, const std::vector<std::pair<std::string, std::string>>& inputs) {
+        bool ok = true;
+        for (const auto& [name, input] : inputs)
+            ok &= check(lexer_name, table, name, std::span(reinterpret_cast<const uint8_t*>(input.data()), input.size()));
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto inputs = std::vector<std::pair<std::string, std::string>>();
+
+    for (int i = 1; i < argc; ++i) {
+        auto in = std::ifstream(argv[i], std::ios::binary);
+        if (!in) {
+            fmt::print("Failed to open '{}'\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+
+        auto ss = std::stringstream();
+        ss << in.rdbuf();
+        auto contents = ss.str();
+        inputs.push_back({argv[i], contents});
+
+        // Make the input long enough for several blocks, with a length that is not a multiple of any lane count.
+        auto repeated = std::string();
+        while (!contents.empty() && repeated.size() < 1024 * 1024)
+            repeated += contents;
+        repeated += contents.substr(0, contents.size() / 3);
+        inputs.push_back({fmt::format("{} (repeated)", argv[i]), repeated});
+    }
+
+    auto rng = std::mt19937(0);
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+    for (size_t size : {0, 1, 3, 16, 127, 128, 129, 1000, 4096 * 8 + 5, 300000}) {
+        auto random = std::string(size, '\0');
+        for (auto& c : random)
+            c = static_cast<char>(byte(rng));
+        inputs.push_back({"random", random});
+    }
+
+    bool ok = check_all("pareas", grammar::lex_table, inputs);
+    ok &= check_all("json", json::lex_table, inputs);
+
+    if (!ok)
+        return EXIT_FAILURE;
+
+    for (auto isa : {Isa::SCALAR, Isa::AVX2, Isa::AVX512}) {
+        const char* status = pareas::host::isa_supported(isa) ? "checked" : "skipped (not supported by this CPU)";
+        fmt::print("{} kernel: {}\n", pareas::host::isa_name(isa), status);
+    }
+
+    fmt::print("All {} inputs match\n", inputs.size());
+    return EXIT_SUCCESS;
+}